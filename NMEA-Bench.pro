@@ -0,0 +1,73 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += release
+
+QMAKE_CXXFLAGS += -std=c++17 -Wall -Wfatal-errors
+
+# Allow the "#pragma omp simd" loops of the batch geometry kernels to be vectorised.
+QMAKE_CXXFLAGS += -fopenmp-simd -fno-math-errno -fno-trapping-math
+
+HEADERS += \
+    headers/allocationCount.h \
+    headers/binaryRoute.h \
+    headers/compactPosition.h \
+    headers/compactRoute.h \
+    headers/earth.h \
+    headers/epochFusion.h \
+    headers/formatPosition.h \
+    headers/geometry.h \
+    headers/gpxReader.h \
+    headers/gpxWriter.h \
+    headers/ingestStats.h \
+    headers/logDirectory.h \
+    headers/logs.h \
+    headers/mappedFile.h \
+    headers/parseDecimal.h \
+    headers/parseNMEA.h \
+    headers/pipelineNMEA.h \
+    headers/position.h \
+    headers/routeDistance.h \
+    headers/routeColumns.h \
+    headers/scanKernels.h \
+    headers/scanNMEA.h \
+    headers/sentenceFormats.h \
+    headers/simplifyRoute.h \
+    headers/spatialIndex.h \
+    headers/spscRing.h \
+    headers/streamNMEA.h \
+    headers/types.h
+
+SOURCES += \
+    src/allocationCount.cpp \
+    src/binaryRoute.cpp \
+    src/compactPosition.cpp \
+    src/compactRoute.cpp \
+    src/earth.cpp \
+    src/epochFusion.cpp \
+    src/formatPosition.cpp \
+    src/geometry.cpp \
+    src/gpxReader.cpp \
+    src/gpxWriter.cpp \
+    src/ingestStats.cpp \
+    src/logDirectory.cpp \
+    src/logs.cpp \
+    src/mappedFile.cpp \
+    src/parseDecimal.cpp \
+    src/parseNMEA.cpp \
+    src/pipelineNMEA.cpp \
+    src/position.cpp \
+    src/routeColumns.cpp \
+    src/routeDistance.cpp \
+    src/scanKernels.cpp \
+    src/scanNMEA.cpp \
+    src/simplifyRoute.cpp \
+    src/spatialIndex.cpp \
+    src/streamNMEA.cpp \
+    src/nmea-bench.cpp
+
+INCLUDEPATH += headers/
+
+TARGET = $$_PRO_FILE_PWD_/execs/nmea-bench
+
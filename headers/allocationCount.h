@@ -0,0 +1,15 @@
+#ifndef ALLOCATIONCOUNT_H_171026
+#define ALLOCATIONCOUNT_H_171026
+
+#include <atomic>
+#include <cstddef>
+
+/* The number of heap allocations made through the global operator new, in any of its forms.
+ *
+ * Linking src/allocationCount.cpp into a program replaces the global allocation functions
+ * with ones that count, so that the tests and benchmarks can check and report how many
+ * allocations a stage makes.
+ */
+extern std::atomic<std::size_t> allocationCount;
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef BINARYROUTE_H_171026
+#define BINARYROUTE_H_171026
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "mappedFile.h"
+#include "parseNMEA.h"
+#include "position.h"
+
+namespace NMEA
+{
+  /* A compact binary archive format for Routes.
+   *
+   * Latitudes and longitudes are stored as fixed-point integers in units of 1e-5
+   * arcminutes (1/6000000 degree), and elevations in decimetres.  Since NMEA sentences
+   * give angles in decimal minutes and elevations to a tenth of a metre, the positions
+   * of routes read from NMEA logs are restored exactly.
+   *
+   * The positions are divided into blocks of 'blockSize' positions.  The first position
+   * of each block is stored in full and the rest as differences from their predecessor,
+   * each value as a zig-zag encoded variable-length integer (so small differences take
+   * a single byte).  An index of the block offsets follows the blocks, so any position
+   * can be found by decoding at most one block.
+   *
+   * Layout (all fixed-width integers are little-endian):
+   *   - header: the magic bytes "NMEAROUT", uint32 version, uint32 block size,
+   *     uint64 position count, uint64 index offset;
+   *   - the blocks;
+   *   - the index: one uint64 file offset per block.
+   */
+  namespace BinaryRoute
+  {
+    const std::size_t defaultBlockSize = 4096;
+
+    // The fixed-point units, per degree and per metre.
+    const double unitsPerDegree = 6000000;
+    const double unitsPerMetre  = 10;
+
+    // Elevations beyond this many metres cannot be represented exactly in decimetres.
+    const double maxElevation = 1e14;
+  }
+
+
+  /* Writes a route in the binary archive format.
+   *
+   * Throws a std::invalid_argument exception if the block size is zero or too large for
+   * its 32-bit field, or an elevation is too large for the format, and a
+   * std::runtime_error if the stream cannot be written.
+   */
+  void writeBinaryRoute(std::ostream &, const Route &, std::size_t blockSize = BinaryRoute::defaultBlockSize);
+
+  void writeBinaryRouteFile(const std::string & path, const Route &,
+                            std::size_t blockSize = BinaryRoute::defaultBlockSize);
+
+
+  /* A memory-mapped binary route archive, read without loading the whole file.
+   *
+   * Throws a std::runtime_error if the file cannot be mapped or is not a valid archive.
+   * The blocks are checked as they are decoded, so reading a position also throws a
+   * std::runtime_error if its block is corrupt (e.g. a coordinate is out of range).
+   */
+  class BinaryRouteFile
+  {
+    public:
+
+      explicit BinaryRouteFile(const std::string & path);
+
+      std::size_t size() const;
+      std::size_t blockSize() const;
+      std::size_t blockCount() const;
+
+      // The position at an index, decoding only the block that contains it.
+      GPS::Position operator[](std::size_t) const;
+
+      // Decodes the whole route.
+      Route toRoute() const;
+
+      /* Appends the positions of one block to any route container with push_back(),
+       * such as Route or RouteColumns.
+       */
+      template <typename RouteContainer>
+      void appendBlock(std::size_t block, RouteContainer & route) const
+      {
+        decodeBlock(block, [&route](const GPS::Position & pos) { route.push_back(pos); return true; });
+      }
+
+      // Appends all of the positions to any route container with push_back().
+      template <typename RouteContainer>
+      void appendTo(RouteContainer & route) const
+      {
+        for (std::size_t block = 0; block < blockCount(); ++block)
+          appendBlock(block, route);
+      }
+
+    private:
+      /* Decodes the positions of a block in order, passing each to the visitor until it
+       * returns false.
+       */
+      template <typename Visitor>
+      void decodeBlock(std::size_t block, Visitor && visitor) const;
+
+      std::uint64_t blockOffset(std::size_t block) const;
+
+      GPS::MappedFile file;
+      std::size_t     positionCount;
+      std::size_t     positionsPerBlock;
+      std::size_t     blocks;
+      std::uint64_t   indexOffset;
+  };
+
+
+  namespace BinaryRoute
+  {
+    /* Reads a zig-zag encoded variable-length integer, advancing 'data'.
+     * Throws a std::runtime_error if the integer does not end before 'end'.
+     */
+    inline std::int64_t readVarint(const unsigned char * & data, const unsigned char * end)
+    {
+      std::uint64_t value = 0;
+      for (unsigned int shift = 0; data != end && shift < 64; shift += 7) {
+        const unsigned char byte = *data++;
+        value |= std::uint64_t(byte & 0x7F) << shift;
+        if (byte < 0x80)
+          return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);
+      }
+      throw std::runtime_error("Corrupt binary route: truncated integer.");
+    }
+
+    /* Adds a difference to a fixed-point value within +/- 'limit'.
+     * Throws a std::runtime_error if the sum would not be within +/- 'limit'.
+     */
+    inline void addDifference(std::int64_t & value, std::int64_t difference, std::int64_t limit)
+    {
+      // Checking the difference first ensures that the sum cannot overflow.
+      if (difference < -2 * limit || difference > 2 * limit || value + difference < -limit || value + difference > limit)
+        throw std::runtime_error("Corrupt binary route: coordinate out of range.");
+      value += difference;
+    }
+  }
+
+  template <typename Visitor>
+  void BinaryRouteFile::decodeBlock(std::size_t block, Visitor && visitor) const
+  {
+    const unsigned char * data = reinterpret_cast<const unsigned char *>(file.data());
+    const unsigned char * end = data + (block + 1 < blocks ? blockOffset(block + 1) : indexOffset);
+    data += blockOffset(block);
+
+    const std::int64_t latLimit = std::int64_t(90 * BinaryRoute::unitsPerDegree);
+    const std::int64_t lonLimit = std::int64_t(180 * BinaryRoute::unitsPerDegree);
+    const std::int64_t eleLimit = std::int64_t(BinaryRoute::maxElevation * BinaryRoute::unitsPerMetre);
+
+    const std::size_t count = std::min(positionsPerBlock, positionCount - block * positionsPerBlock);
+    std::int64_t lat = 0, lon = 0, ele = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      BinaryRoute::addDifference(lat, BinaryRoute::readVarint(data, end), latLimit);
+      BinaryRoute::addDifference(lon, BinaryRoute::readVarint(data, end), lonLimit);
+      BinaryRoute::addDifference(ele, BinaryRoute::readVarint(data, end), eleLimit);
+      if (!visitor(GPS::Position(lat / BinaryRoute::unitsPerDegree, lon / BinaryRoute::unitsPerDegree,
+                                 ele / BinaryRoute::unitsPerMetre)))
+        return;
+    }
+  }
+
+
+  // Reads a whole route from a binary archive file.
+  Route routeFromBinaryFile(const std::string & path);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef COMPACTPOSITION_H_171026
+#define COMPACTPOSITION_H_171026
+
+#include <cstdint>
+
+#include "position.h"
+#include "types.h"
+
+namespace GPS
+{
+  /* A Position stored in fixed point, in 12 bytes rather than 24: latitude and longitude
+   * in units of 1e-5 arcminute (1/6,000,000 degree, about 2 cm on the ground), and
+   * elevation in decimetres.
+   *
+   * NMEA sentences give coordinates in degrees and decimal minutes, so a coordinate with
+   * up to 5 decimal places of minutes (consumer receivers give 4) and an elevation with up
+   * to 1 decimal place convert to a CompactPosition, and back, to exactly the Position
+   * that the NMEA parser produces.  Other values are rounded to the nearest unit.
+   */
+  class CompactPosition
+  {
+    public:
+
+      static constexpr double unitsPerDegree = 6000000;
+      static constexpr double unitsPerMetre  = 10;
+
+      /* Throws a std::invalid_argument exception if the elevation is beyond the
+       * representable range of about +/-214,748 km.
+       */
+      explicit CompactPosition(const Position &);
+
+      // Every CompactPosition converts exactly to a Position.
+      operator Position() const;
+
+      degrees latitude() const;
+      degrees longitude() const;
+      metres  elevation() const;
+
+      // As Position::distanceBetween().
+      static metres distanceBetween(CompactPosition, CompactPosition);
+
+      friend bool operator==(CompactPosition a, CompactPosition b)
+      {
+        return a.lat == b.lat && a.lon == b.lon && a.ele == b.ele;
+      }
+
+      friend bool operator!=(CompactPosition a, CompactPosition b)
+      {
+        return !(a == b);
+      }
+
+    private:
+      std::int32_t lat;
+      std::int32_t lon;
+      std::int32_t ele;
+  };
+
+  static_assert(sizeof(CompactPosition) == 12, "CompactPosition should have no padding");
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef COMPACTROUTE_H_171026
+#define COMPACTROUTE_H_171026
+
+#include <cstddef>
+#include <vector>
+
+#include "compactPosition.h"
+#include "parseNMEA.h"
+#include "position.h"
+
+namespace NMEA
+{
+  /* A route of CompactPositions, taking half the memory of a Route.
+   *
+   * Positions are appended with push_back(), so a CompactRoute can be filled directly by
+   * appendRouteFromLog() and appendRouteFromLogBuffer().  Indexing and iteration yield
+   * GPS::CompactPosition values, which convert implicitly to GPS::Position.
+   */
+  class CompactRoute
+  {
+    public:
+      using const_iterator = std::vector<GPS::CompactPosition>::const_iterator;
+
+      CompactRoute() = default;
+      explicit CompactRoute(const Route &);
+
+      std::size_t size() const;
+      bool empty() const;
+      void reserve(std::size_t);
+      void clear();
+
+      // Throws a std::invalid_argument exception if the elevation is out of range (see CompactPosition).
+      void push_back(const GPS::Position &);
+      void push_back(GPS::CompactPosition);
+
+      GPS::CompactPosition operator[](std::size_t) const;
+
+      const_iterator begin() const;
+      const_iterator end() const;
+
+      Route toRoute() const;
+
+    private:
+      std::vector<GPS::CompactPosition> positions;
+  };
+}
+
+#endif
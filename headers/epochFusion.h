@@ -0,0 +1,81 @@
+#ifndef EPOCHFUSION_H_171026
+#define EPOCHFUSION_H_171026
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parseNMEA.h"
+#include "position.h"
+#include "types.h"
+
+namespace NMEA
+{
+  /* Parses the UTC time of a NMEA sentence, in the form hhmmss with an optional decimal
+   * fraction of a second (which is discarded), e.g. "094627.000".  A leading zero hour
+   * digit may be omitted, as in the GLL time "82319".
+   *
+   * Returns false (leaving 'time' unchanged) if the field is not a valid time of day.
+   */
+  bool parseTimeOfDay(std::string_view, GPS::seconds & time);
+
+
+  /* A Position with the UTC time of day (in seconds after midnight) at which it was fixed.
+   */
+  struct Fix
+  {
+      GPS::seconds  time;
+      GPS::Position position;
+  };
+
+
+  /* A track is a sequence of timestamped fixes, one per epoch.
+   */
+  using Track = std::vector<Fix>;
+
+
+  /* Fuses consecutive sentences that report the same epoch into a single Fix.
+   *
+   * Receivers typically report each epoch in several sentences (e.g. a GGA and an RMC
+   * with the same time field).  Sentences are fused while their time fields are
+   * identical; the coordinates are those of the first sentence of the epoch, and the
+   * elevation is taken from the first sentence whose format carries one (GGA).
+   * Sentences whose time field is not a valid time of day are ignored.
+   */
+  class EpochFusion
+  {
+    public:
+
+      /* Adds the Position decoded from a valid sentence.
+       * Returns the Fix of the previous epoch if this sentence starts a new one.
+       *
+       * Pre-condition: the sentence data is of a supported format, with all its fields.
+       */
+      std::optional<Fix> add(const SentenceData &, const GPS::Position &);
+
+      // Returns the Fix of the final epoch, if any, and starts afresh.
+      std::optional<Fix> finish();
+
+    private:
+      std::optional<Fix> pending;
+      std::string        pendingTimeField;
+      bool               pendingHasElevation = false;
+  };
+
+
+  /* As routeFromLog(), but fuses the sentences of each epoch into one timestamped Fix
+   * (see EpochFusion).  For logs that report every epoch as both a GGA and an RMC
+   * sentence, the track has half as many points as the route.
+   */
+  Track trackFromLog(std::istream &);
+
+
+  /* As trackFromLog(), but reads the sentences from an in-memory buffer.
+   * Lines may end with either "\n" or "\r\n".
+   */
+  Track trackFromLogBuffer(std::string_view);
+}
+
+#endif
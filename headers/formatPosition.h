@@ -0,0 +1,55 @@
+#ifndef FORMATPOSITION_H_171026
+#define FORMATPOSITION_H_171026
+
+#include <charconv>
+#include <cstddef>
+
+#include "position.h"
+
+namespace GPS
+{
+  enum class PositionLayout
+  {
+      attributes, // lat="52.91249953" lon="-1.18402513" ele="53"
+      csv,        // 52.91249953,-1.18402513,53
+      ddm         // 5254.7500,N,00111.0415,W,53 (the DDM fields of an NMEA sentence)
+  };
+
+
+  struct PositionFormat
+  {
+      // The shortest representation that reads back as the same double.
+      static constexpr int shortest = -1;
+
+      static constexpr int maxPrecision = 9;
+
+      PositionLayout layout = PositionLayout::attributes;
+
+      /* The number of decimal places of every number, or 'shortest'.
+       * In the DDM layout this applies to the minutes, which have 4 decimal places (as in
+       * NMEA sentences) if the precision is 'shortest'.
+       */
+      int precision = shortest;
+
+      bool includeElevation = true;
+  };
+
+
+  // Enough for any Position in any layout, except for fixed precision with a huge elevation.
+  constexpr std::size_t maxFormattedPositionLength = 128;
+
+
+  /* Writes a Position into the characters [first, last), without allocating memory.
+   *
+   * Like std::to_chars(), returns a pointer past the last character written, or the
+   * error std::errc::value_too_large (with the contents of the range unspecified) if the
+   * Position does not fit.  The text is not null-terminated.
+   *
+   * Throws a std::invalid_argument exception if the precision is neither 'shortest' nor
+   * in the range [0, PositionFormat::maxPrecision].
+   */
+  std::to_chars_result formatPosition(char * first, char * last, const Position &,
+                                      const PositionFormat & = PositionFormat());
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef GPXREADER_H_171026
+#define GPXREADER_H_171026
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "mappedFile.h"
+#include "parseNMEA.h"
+#include "position.h"
+
+namespace GPS
+{
+  /* A forward-only reader of the route points (<rtept>) and track points (<trkpt>) of a
+   * GPX document, in document order.
+   *
+   * The reader scans the document text directly, without building a tree of elements:
+   * it reads the 'lat' and 'lon' attributes and the optional <ele> child of each point,
+   * and skips every other element, as well as comments, CDATA sections and processing
+   * instructions.  Points without an <ele> have an elevation of 0.
+   *
+   * The document must outlive the reader.  Throws a std::invalid_argument exception from
+   * next() if a point is malformed (e.g. a missing or non-numeric coordinate, or an
+   * unterminated element).
+   */
+  class GPXReader
+  {
+    public:
+
+      explicit GPXReader(std::string_view document);
+
+      // The next point, or none at the end of the document.
+      std::optional<Position> next();
+
+    private:
+      Position readPoint(std::string_view elementName);
+
+      std::string_view rest;
+  };
+
+
+  /* Reads the points of a GPX document into any route container with push_back(), such
+   * as NMEA::Route or NMEA::RouteColumns.
+   */
+  template <typename RouteContainer>
+  void appendRouteFromGPXBuffer(std::string_view document, RouteContainer & route)
+  {
+    GPXReader reader(document);
+    while (std::optional<Position> pos = reader.next())
+      route.push_back(*pos);
+  }
+
+
+  /* As appendRouteFromGPXBuffer(), but reads the document from a memory-mapped file.
+   *
+   * Throws a std::runtime_error if the file cannot be opened or mapped.
+   */
+  template <typename RouteContainer>
+  void appendRouteFromGPXFile(const std::string & path, RouteContainer & route)
+  {
+    const MappedFile file(path);
+    appendRouteFromGPXBuffer(file.contents(), route);
+  }
+
+
+  NMEA::Route routeFromGPXBuffer(std::string_view document);
+
+  NMEA::Route routeFromGPXFile(const std::string & path);
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef GPXWRITER_H_171026
+#define GPXWRITER_H_171026
+
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "parseNMEA.h"
+#include "position.h"
+
+namespace GPS
+{
+  /* A streaming writer of GPX 1.1 documents containing routes (<rte>) and tracks (<trk>).
+   *
+   * The document is formatted into a fixed buffer, which is written to the stream in
+   * large blocks, so the cost per point is that of formatting its three numbers (with
+   * the shortest representation that reads back as the same double) and no memory is
+   * allocated per point.
+   *
+   * The <gpx> element is opened on construction, and closed by finish().
+   * Throws a std::logic_error if elements are begun or ended out of order, and a
+   * std::runtime_error if the stream cannot be written.
+   */
+  class GPXWriter
+  {
+    public:
+
+      static constexpr std::size_t bufferSize = 64 * 1024;
+
+      explicit GPXWriter(std::ostream &, std::string_view creator = "NTU-GPS");
+
+      GPXWriter(const GPXWriter &) = delete;
+      GPXWriter & operator=(const GPXWriter &) = delete;
+
+      // Begin a route, whose points are added with addPoint().
+      void beginRoute(std::string_view name = {});
+      void endRoute();
+
+      // Begin a track, whose points are added with addPoint() within track segments.
+      void beginTrack(std::string_view name = {});
+      void beginTrackSegment();
+      void endTrackSegment();
+      void endTrack();
+
+      // Add a route point or a track point, within the current route or track segment.
+      void addPoint(const Position &);
+
+      // Write a whole route, or a track with a single segment.
+      void writeRoute(const NMEA::Route &, std::string_view name = {});
+      void writeTrack(const NMEA::Route &, std::string_view name = {});
+
+      // Close the document and write any buffered output to the stream.
+      void finish();
+
+    private:
+      enum class State { document, route, track, trackSegment, finished };
+
+      void expectState(State, const char * operation) const;
+      void beginElement(State required, State next, std::string_view openTag, std::string_view name);
+      void endElement(State required, State next, std::string_view closeTag);
+
+      void append(std::string_view);
+      void appendEscaped(std::string_view);
+      void appendNumber(double);
+      void reserve(std::size_t length);
+      void flush();
+
+      std::ostream & out;
+      std::vector<char> buffer;
+      std::size_t used;
+      State state;
+  };
+
+
+  // Write a GPX document containing a single route or track.
+  void writeGPXRoute(std::ostream &, const NMEA::Route &, std::string_view name = {});
+  void writeGPXTrack(std::ostream &, const NMEA::Route &, std::string_view name = {});
+}
+
+#endif
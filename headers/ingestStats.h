@@ -0,0 +1,99 @@
+#ifndef INGESTSTATS_H_171026
+#define INGESTSTATS_H_171026
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "scanNMEA.h"
+
+namespace NMEA
+{
+  // The outcome of parsing a line that scanSentence() accepted (see ScanStatus for the others).
+  enum class LineOutcome
+  {
+      accepted,
+      unsupportedFormat, // not a GLL, GGA or RMC sentence
+      invalidFields,     // the wrong number of fields, or fields with the wrong classes of characters
+      invalidData        // the fields could not be converted to a Position
+  };
+
+
+  // The stages of parsing a log, whose cumulative times are recorded.
+  enum class IngestStage
+  {
+      read,     // reading lines from a stream (not used when parsing a buffer)
+      scan,     // scanSentence()
+      validate, // selecting the sentence format and checking its fields
+      decode    // extracting the fields and converting them to a Position
+  };
+
+
+  /* Statistics of parsing a log: the number of lines with each outcome (including each
+   * reason for which scanSentence() rejects a line), and the cumulative time spent in
+   * each stage, measured with std::chrono::steady_clock.
+   *
+   * The parsing functions take either an IngestStats or a NoStats, which are both stats
+   * policies: they record counts with count(), and times with addTime() between the
+   * TimePoints from now().  Every function of NoStats does nothing, so that parsing
+   * without statistics costs nothing more than before they existed.
+   */
+  class IngestStats
+  {
+    public:
+
+      using Clock = std::chrono::steady_clock;
+      using TimePoint = Clock::time_point;
+
+      static TimePoint now() { return Clock::now(); }
+
+      void addTime(IngestStage stage, TimePoint start, TimePoint end)
+      {
+        stageTimes[std::size_t(stage)] += end - start;
+      }
+
+      void count(ScanStatus status) { ++scanStatuses[std::size_t(status)]; }
+      void count(LineOutcome outcome) { ++outcomes[std::size_t(outcome)]; }
+
+      // The number of lines parsed.
+      std::uint64_t lines() const;
+
+      // The number of lines rejected for any reason.
+      std::uint64_t rejected() const;
+
+      // The number of lines scanned with the given status (ScanStatus::ok for those that pass).
+      std::uint64_t lines(ScanStatus) const;
+
+      // The number of lines, of those that pass scanning, with the given outcome.
+      std::uint64_t lines(LineOutcome) const;
+
+      Clock::duration time(IngestStage) const;
+
+      // Adds the statistics of another part of the same log, e.g. parsed on another thread.
+      IngestStats & operator+=(const IngestStats &);
+
+    private:
+      static constexpr std::size_t SCAN_STATUSES = std::size_t(ScanStatus::checksumMismatch) + 1;
+      static constexpr std::size_t OUTCOMES = std::size_t(LineOutcome::invalidData) + 1;
+      static constexpr std::size_t STAGES = std::size_t(IngestStage::decode) + 1;
+
+      std::array<std::uint64_t, SCAN_STATUSES> scanStatuses = {};
+      std::array<std::uint64_t, OUTCOMES> outcomes = {};
+      std::array<Clock::duration, STAGES> stageTimes = {};
+  };
+
+
+  // The stats policy that records nothing.
+  struct NoStats
+  {
+    struct TimePoint {};
+
+    static TimePoint now() { return {}; }
+    void addTime(IngestStage, TimePoint, TimePoint) {}
+    void count(ScanStatus) {}
+    void count(LineOutcome) {}
+  };
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LOGDIRECTORY_H_171026
+#define LOGDIRECTORY_H_171026
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "parseNMEA.h"
+
+namespace NMEA
+{
+  // The route parsed from one log file.
+  struct LogFileRoute
+  {
+      std::string path;
+      Route route;
+  };
+
+
+  /* Parses every log file (every regular file with the extension ".log") directly within a
+   * directory, such as GPS::LogFiles::NMEALogsDir, as by routeFromLogFile().  Returns one
+   * route per file, in order of path.
+   *
+   * The files are parsed concurrently by a pool of threads, each parsing one file at a
+   * time, and the largest files are started first so that a large file is not left to
+   * finish alone at the end.  A thread count of 0 uses one thread per hardware thread.
+   * At most 'maxOpenFiles' files are mapped into memory at once (0 for no limit other than
+   * the thread count), which bounds the memory mapped by the ingest.
+   *
+   * Throws a std::runtime_error if the directory cannot be read, or if a file cannot be
+   * opened or mapped (in which case the files not yet started are not parsed).
+   */
+  std::vector<LogFileRoute> routesFromLogDirectory(const std::string & directory,
+                                                   unsigned int threads = 0,
+                                                   std::size_t maxOpenFiles = 0);
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MAPPEDFILE_H_171026
+#define MAPPEDFILE_H_171026
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace GPS
+{
+  /* A read-only memory mapping of an entire file.
+   * The mapping is released when the object is destroyed.
+   */
+  class MappedFile
+  {
+    public:
+
+      /* Maps the named file into memory.
+       *
+       * Throws a std::runtime_error if the file cannot be opened or mapped.
+       */
+      explicit MappedFile(const std::string & path);
+
+      MappedFile(MappedFile &&) noexcept;
+      MappedFile & operator=(MappedFile &&) noexcept;
+
+      MappedFile(const MappedFile &) = delete;
+      MappedFile & operator=(const MappedFile &) = delete;
+
+      ~MappedFile();
+
+      const char * data() const;
+      std::size_t  size() const;
+
+      std::string_view contents() const;
+
+    private:
+      void release();
+
+      const char * addr;
+      std::size_t  length;
+  };
+}
+
+#endif
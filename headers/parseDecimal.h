@@ -0,0 +1,29 @@
+#ifndef PARSEDECIMAL_H_171026
+#define PARSEDECIMAL_H_171026
+
+#include <string_view>
+
+#include "types.h"
+
+namespace GPS
+{
+  /* Parse a decimal number (an optional sign, digits with an optional decimal point, and
+   * an optional exponent) from the start of the string, converting the digits directly to
+   * the nearest double.  Like std::stod, any characters after the number are ignored;
+   * unlike std::stod, the conversion does not depend on the locale and does not allocate.
+   *
+   * Returns false (leaving 'value' unchanged) if the string does not start with a number.
+   */
+  bool parseDecimal(std::string_view, double & value);
+
+
+  /* Parse a DDM (degrees and decimal minutes) angle, such as "5425.31", from the start of
+   * the string, and convert it to decimal degrees.  For up to 14 decimal places of minutes
+   * the result is the nearest double to the exact angle written in the string.
+   *
+   * Returns false (leaving 'value' unchanged) if the string does not start with a number.
+   */
+  bool parseDDM(std::string_view, degrees & value);
+}
+
+#endif
@@ -1,13 +1,19 @@
 #ifndef PARSENMEA_H_211217
 #define PARSENMEA_H_211217
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 #include <utility>
+#include <optional>
 #include <istream>
 
+#include "ingestStats.h"
 #include "position.h"
+#include "scanNMEA.h"
 
 namespace NMEA
 {
@@ -53,13 +59,129 @@ namespace NMEA
   SentenceData extractSentenceData(std::string);
 
 
+  /* Extracts the sentence format and the field contents from a sentence that has
+   * already been scanned by scanSentence().
+   *
+   * Pre-condition: the scanned sentence is well-formed.
+   */
+  SentenceData extractSentenceData(const SentenceView &);
+
+
   /* Computes a Position from NMEA Sentence Data.
    * Currently only supports the GLL, GGA and RMC sentence formats.
    *
    * Throws a std::invalid_argument exception for unsupported sentence formats, or
    * if the neccessary data fields are missing or contain invalid data.
    */
-  GPS::Position positionFromSentenceData(SentenceData);
+  GPS::Position positionFromSentenceData(const SentenceData &);
+
+
+  // The reasons for which a Position cannot be computed from NMEA Sentence Data.
+  enum class DecodeError : std::uint8_t
+  {
+      none,
+      unsupportedFormat,   // not a GLL, GGA or RMC sentence
+      missingFields,       // fewer fields than the format requires
+      invalidCoordinate,   // a latitude or longitude that is not a DDM number
+      invalidElevation,    // an elevation that is not a decimal number
+      latitudeOutOfRange,  // a latitude beyond 90 degrees
+      longitudeOutOfRange  // a longitude beyond 180 degrees (checked after the latitude)
+  };
+
+
+  // The message of the exception thrown by positionFromSentenceData() for the error.
+  const char * describe(DecodeError);
+
+
+  // Either a Position, or the reason it could not be decoded.
+  class DecodeResult
+  {
+    public:
+      DecodeResult(GPS::Position pos) : pos(pos), err(DecodeError::none) {}
+      DecodeResult(DecodeError err) : err(err) {}
+
+      explicit operator bool() const { return err == DecodeError::none; }
+
+      DecodeError error() const { return err; }
+
+      // Pre-condition: the result is not an error.
+      const GPS::Position & position() const { return *pos; }
+
+    private:
+      std::optional<GPS::Position> pos;
+      DecodeError err;
+  };
+
+
+  /* As positionFromSentenceData(), but returns the reason for which the data cannot be
+   * decoded, rather than throwing an exception.  This is much cheaper for logs in which
+   * many sentences are bad.
+   */
+  DecodeResult tryPositionFromSentenceData(const SentenceData &) noexcept;
+
+
+  /* Determine whether a sentence format is supported (currently GLL, GGA and RMC).
+   */
+  bool isSupportedFormat(std::string_view);
+
+
+  /* Determine whether the fields of a scanned sentence have the layout accepted by
+   * routeFromLog: the expected number of fields, each containing the expected class
+   * of characters (digits, decimals, or the permitted N/S/E/W and A/V flag letters).
+   *
+   * Returns false for unsupported sentence formats.
+   */
+  bool hasValidFields(const SentenceView &);
+
+
+  /* Computes the Position from a single line of a log, if it contains a valid sentence
+   * (see routeFromLog() below).  A trailing '\r' is ignored.
+   *
+   * Returns an empty optional for lines that do not contain a valid sentence.
+   */
+  std::optional<GPS::Position> positionFromLogLine(std::string_view line);
+
+
+  /* Reusable storage for parsing a log one line at a time.
+   *
+   * The context owns the line buffer and the sentence fields, which are overwritten
+   * (rather than reallocated) for each sentence.  Once their storage has grown to fit
+   * the longest sentence, parsing a valid sentence performs no heap allocation.
+   */
+  class ParserContext
+  {
+    public:
+
+      /* Reads the next line of the stream into the context's line buffer.
+       * Returns false at the end of the stream.
+       */
+      bool readLine(std::istream &);
+
+      // The line most recently read by readLine().
+      std::string_view line() const;
+
+      // As positionFromLogLine(), for the line most recently read by readLine().
+      std::optional<GPS::Position> parseLine();
+
+      // As positionFromLogLine(), reusing the context's storage.
+      std::optional<GPS::Position> parseLine(std::string_view line);
+
+      /* As parseLine(), recording the outcome of the line and the time of each stage in a
+       * stats policy: IngestStats or NoStats (see ingestStats.h).
+       */
+      template <typename Stats>
+      std::optional<GPS::Position> parseLine(std::string_view line, Stats &);
+
+      // The format and fields of the last valid sentence parsed.
+      const SentenceData & sentenceData() const;
+
+    private:
+      void extractFields();
+
+      std::string  lineBuffer;
+      SentenceView view;
+      SentenceData data;
+  };
 
 
   /* A route is a sequence of positions.
@@ -78,6 +200,90 @@ namespace NMEA
    */
   Route routeFromLog(std::istream &);
 
+
+  // As routeFromLog(), adding the statistics of the parse to 'stats'.
+  Route routeFromLog(std::istream &, IngestStats & stats);
+
+
+  /* As routeFromLog(), but reads the sentences from an in-memory buffer.
+   * Lines may end with either "\n" or "\r\n".
+   *
+   * If more than one thread is requested, the buffer is split at line boundaries into
+   * chunks that are parsed concurrently and joined in order, producing the same Route
+   * as the serial parse.  A thread count of 0 uses one thread per hardware thread.
+   */
+  Route routeFromLogBuffer(std::string_view, unsigned int threads = 1);
+
+
+  // As routeFromLogBuffer(), adding the statistics of the parse (on all threads) to 'stats'.
+  Route routeFromLogBuffer(std::string_view, IngestStats & stats, unsigned int threads = 1);
+
+
+  /* As routeFromLogBuffer(), but reads the sentences directly from a memory-mapped log file.
+   *
+   * Throws a std::runtime_error if the file cannot be opened or mapped.
+   */
+  Route routeFromLogFile(const std::string & path, unsigned int threads = 1);
+
+
+  // As routeFromLogFile(), adding the statistics of the parse (on all threads) to 'stats'.
+  Route routeFromLogFile(const std::string & path, IngestStats & stats, unsigned int threads = 1);
+
+
+  /* As routeFromLog(), but appends the Positions to an existing route container with
+   * push_back(), so that any container of Positions (such as Route or RouteColumns) can
+   * be filled directly.
+   */
+  template <typename RouteContainer>
+  void appendRouteFromLog(std::istream & fs, RouteContainer & route)
+  {
+    NoStats stats;
+    appendRouteFromLog(fs, route, stats);
+  }
+
+
+  // As appendRouteFromLog(), recording statistics in a stats policy (see ingestStats.h).
+  template <typename RouteContainer, typename Stats>
+  void appendRouteFromLog(std::istream & fs, RouteContainer & route, Stats & stats)
+  {
+    ParserContext context;
+    while(true){
+      const auto start = stats.now();
+      const bool read = context.readLine(fs);
+      stats.addTime(IngestStage::read, start, stats.now());
+      if(!read)
+        break;
+      if(std::optional<GPS::Position> pos = context.parseLine(context.line(), stats))
+        route.push_back(*pos);
+    }
+  }
+
+
+  /* As routeFromLogBuffer() (on one thread), but appends the Positions to an existing
+   * route container with push_back().
+   */
+  template <typename RouteContainer>
+  void appendRouteFromLogBuffer(std::string_view log, RouteContainer & route)
+  {
+    NoStats stats;
+    appendRouteFromLogBuffer(log, route, stats);
+  }
+
+
+  // As appendRouteFromLogBuffer(), recording statistics in a stats policy (see ingestStats.h).
+  template <typename RouteContainer, typename Stats>
+  void appendRouteFromLogBuffer(std::string_view log, RouteContainer & route, Stats & stats)
+  {
+    ParserContext context;
+    while(!log.empty()){
+      const char * newline = static_cast<const char *>(std::memchr(log.data(), '\n', log.size()));
+      const std::size_t lineLength = newline ? newline - log.data() : log.size();
+      if(std::optional<GPS::Position> pos = context.parseLine(log.substr(0, lineLength), stats))
+        route.push_back(*pos);
+      log.remove_prefix(newline ? lineLength + 1 : lineLength);
+    }
+  }
+
 }
 
 #endif
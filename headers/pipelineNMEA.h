@@ -0,0 +1,52 @@
+#ifndef PIPELINENMEA_H_171026
+#define PIPELINENMEA_H_171026
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+#include "parseNMEA.h"
+
+namespace NMEA
+{
+  struct PipelineOptions
+  {
+      // The number of bytes read at a time (more if a line is longer).
+      std::size_t bufferSize = 1 << 20;
+
+      // The number of buffers (or parsed routes) that each queue can hold.
+      std::size_t queueDepth = 4;
+
+      // The number of parser threads; 0 for one per hardware thread, less one for the reader.
+      unsigned int workers = 0;
+  };
+
+
+  /* As routeFromLog(), but overlaps reading the stream with parsing it.
+   *
+   * A reader thread reads the stream in large buffers, each ending at a line boundary, and
+   * deals them in turn to the parser threads through one lock-free single-producer,
+   * single-consumer ring per parser (see SPSCRing).  Each parser returns its routes through
+   * a second ring, and the calling thread collects them in the order of the buffers, so
+   * the Route is the same as that of routeFromLog().
+   *
+   * This keeps the parsers busy while a slow stream (e.g. on a network filesystem) delivers
+   * data.  At most workers * (queueDepth + 1) + 1 buffers are in memory at once.
+   *
+   * If reading the stream or parsing a buffer throws an exception, or a thread cannot be
+   * started, every stage stops and the first such exception is rethrown to the caller
+   * once all of the threads have finished.
+   *
+   * Throws a std::invalid_argument exception if the buffer size or queue depth is 0.
+   */
+  Route routeFromLogPipelined(std::istream &, const PipelineOptions & = PipelineOptions());
+
+
+  /* As routeFromLogPipelined(), reading the named file.
+   *
+   * Throws a std::runtime_error if the file cannot be opened.
+   */
+  Route routeFromLogFilePipelined(const std::string & path, const PipelineOptions & = PipelineOptions());
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef POSITION_H_211217
 #define POSITION_H_211217
 
+#include <optional>
 #include <string>
 
 #include "types.h"
@@ -17,6 +18,12 @@ namespace GPS
       Position(degrees lat, degrees lon, metres ele = 0.0);
 
 
+      /* As the constructor above, but returns an empty optional, rather than throwing an
+       * exception, if the latitude or longitude is out of range.
+       */
+      static std::optional<Position> fromDegrees(degrees lat, degrees lon, metres ele = 0.0) noexcept;
+
+
       /* Construct a Position from strings containing a decimal degrees
        * representation of latitude and longitude, and (optionally) elevation in
        * metres.
@@ -0,0 +1,99 @@
+#ifndef ROUTECOLUMNS_H_171026
+#define ROUTECOLUMNS_H_171026
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "parseNMEA.h"
+#include "position.h"
+#include "types.h"
+
+namespace NMEA
+{
+  /* A route stored column-wise: contiguous arrays of latitudes, longitudes and
+   * elevations, so that a pass over one column does not read the others.
+   *
+   * Positions are appended with push_back(), so a RouteColumns can be filled directly by
+   * appendRouteFromLog() and appendRouteFromLogBuffer().  Indexing and iteration yield
+   * GPS::Position values, for compatibility with code written for Route.
+   */
+  class RouteColumns
+  {
+    public:
+
+      class const_iterator;
+
+      RouteColumns() = default;
+      explicit RouteColumns(const Route &);
+
+      std::size_t size() const;
+      bool empty() const;
+
+      void reserve(std::size_t);
+      void clear();
+
+      void push_back(const GPS::Position &);
+      void push_back(GPS::degrees lat, GPS::degrees lon, GPS::metres ele = 0.0);
+
+      const std::vector<GPS::degrees> & latitudes() const;
+      const std::vector<GPS::degrees> & longitudes() const;
+      const std::vector<GPS::metres>  & elevations() const;
+
+      // Reconstructs the Position at an index.
+      GPS::Position operator[](std::size_t) const;
+
+      const_iterator begin() const;
+      const_iterator end() const;
+
+      Route toRoute() const;
+
+    private:
+      std::vector<GPS::degrees> lats;
+      std::vector<GPS::degrees> lons;
+      std::vector<GPS::metres>  eles;
+  };
+
+
+  /* Iterates over a RouteColumns, yielding Positions by value.
+   *
+   * As each Position is reconstructed, dereferencing returns a prvalue rather than a
+   * reference, so this is only an input iterator; it also supports the random-access
+   * arithmetic, but algorithms that require forward iterators must not be given it.
+   */
+  class RouteColumns::const_iterator
+  {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type        = GPS::Position;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = void;
+      using reference         = GPS::Position;
+
+      const_iterator(const RouteColumns * columns, std::size_t index) : columns(columns), index(index) {}
+
+      GPS::Position operator*() const { return (*columns)[index]; }
+      GPS::Position operator[](difference_type n) const { return (*columns)[index + n]; }
+
+      const_iterator & operator++() { ++index; return *this; }
+      const_iterator operator++(int) { const_iterator old = *this; ++index; return old; }
+      const_iterator & operator--() { --index; return *this; }
+      const_iterator operator--(int) { const_iterator old = *this; --index; return old; }
+      const_iterator & operator+=(difference_type n) { index += n; return *this; }
+      const_iterator & operator-=(difference_type n) { index -= n; return *this; }
+
+      friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+      friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+      friend difference_type operator-(const const_iterator & a, const const_iterator & b) { return difference_type(a.index) - difference_type(b.index); }
+
+      friend bool operator==(const const_iterator & a, const const_iterator & b) { return a.index == b.index; }
+      friend bool operator!=(const const_iterator & a, const const_iterator & b) { return a.index != b.index; }
+      friend bool operator<(const const_iterator & a, const const_iterator & b) { return a.index < b.index; }
+
+    private:
+      const RouteColumns * columns;
+      std::size_t index;
+  };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ROUTEDISTANCE_H_171026
+#define ROUTEDISTANCE_H_171026
+
+#include <cstddef>
+#include <vector>
+
+#include "compactRoute.h"
+#include "position.h"
+#include "routeColumns.h"
+#include "types.h"
+
+namespace GPS
+{
+  /* Batch versions of Position::distanceBetween() over contiguous arrays of latitudes and
+   * longitudes (in degrees), using the same haversine approximation.  The trigonometric
+   * functions are evaluated by vectorised polynomial kernels, and cos(latitude) is computed
+   * once per point and shared by the two segments that meet there.
+   *
+   * Results agree with Position::distanceBetween() to a relative difference below 1e-12.
+   */
+
+  // The distances between consecutive points; 'distances' must have room for n-1 values.
+  void segmentDistances(const degrees * lats, const degrees * lons, std::size_t n, metres * distances);
+
+  // The total length of the path through n points.
+  metres routeLength(const degrees * lats, const degrees * lons, std::size_t n);
+
+  // The distances from one position to each of n points; 'distances' must have room for n values.
+  void distancesFrom(const Position & origin, const degrees * lats, const degrees * lons,
+                     std::size_t n, metres * distances);
+}
+
+namespace NMEA
+{
+  // The distances between consecutive positions of a route (one fewer than the positions).
+  std::vector<GPS::metres> segmentDistances(const RouteColumns &);
+  std::vector<GPS::metres> segmentDistances(const Route &);
+  std::vector<GPS::metres> segmentDistances(const CompactRoute &);
+
+  // The total length of a route.
+  GPS::metres routeLength(const RouteColumns &);
+  GPS::metres routeLength(const Route &);
+  GPS::metres routeLength(const CompactRoute &);
+
+  // The distances from one position to every position of a route.
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const RouteColumns &);
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const Route &);
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const CompactRoute &);
+}
+
+#endif
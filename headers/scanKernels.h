@@ -0,0 +1,48 @@
+#ifndef SCANKERNELS_H_171026
+#define SCANKERNELS_H_171026
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NMEA
+{
+  /* The byte-scanning kernels used by scanSentence().
+   * The fastest kernel supported by the CPU is selected when the program starts.
+   */
+  enum class ScanKernel
+  {
+      scalar,
+      sse2,
+      avx2
+  };
+
+
+  // Determine whether the CPU (and the build) supports a kernel.
+  bool isScanKernelSupported(ScanKernel);
+
+  // The kernel currently used by scanSentence().
+  ScanKernel selectedScanKernel();
+
+  /* Select the kernel used by scanSentence(), e.g. to compare or test implementations.
+   *
+   * Throws a std::invalid_argument exception if the kernel is not supported.
+   */
+  void selectScanKernel(ScanKernel);
+
+
+  /* The XOR reduction of 'length' bytes starting at 'data', using the selected kernel.
+   */
+  std::uint8_t xorReduce(const char * data, std::size_t length);
+
+
+  /* Finds the offsets (relative to 'data') of every ',', '*' and '$' character among
+   * 'length' bytes, using the selected kernel.  The first 'capacity' offsets are stored
+   * in ascending order in 'offsets'.
+   *
+   * Returns the total number of such characters, which may exceed 'capacity'.
+   */
+  std::size_t findDelimiters(const char * data, std::size_t length,
+                             std::uint32_t * offsets, std::size_t capacity);
+}
+
+#endif
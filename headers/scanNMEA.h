@@ -0,0 +1,84 @@
+#ifndef SCANNMEA_H_171026
+#define SCANNMEA_H_171026
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace NMEA
+{
+  /* The outcome of scanning a candidate NMEA sentence.
+   * Every value other than 'ok' and 'checksumMismatch' means the sentence is ill-formed.
+   */
+  enum class ScanStatus
+  {
+      ok,
+      tooShort,          // fewer characters than the minimal sentence "$GPXXX*hh"
+      missingPrefix,     // does not start with "$GP"
+      invalidFormat,     // the format ID is not three uppercase letters followed by ',' or '*'
+      missingChecksum,   // the third character from the end is not '*'
+      invalidChecksum,   // the last two characters are not hexadecimal digits
+      reservedCharacter, // a '$' or '*' appears within the data fields
+      checksumMismatch   // well-formed, but the checksum does not match the data
+  };
+
+
+  /* A non-owning view of a scanned NMEA sentence.
+   * The view refers to the characters of the scanned string, which must outlive it.
+   *
+   * The offsets of the first 'maxFields' fields are recorded; sentences with more
+   * fields are still scanned (and may be well-formed), but only the first 'maxFields'
+   * fields can be accessed through field().
+   */
+  struct SentenceView
+  {
+      // Sufficient for any sentence within the NMEA 0183 limit of 82 characters.
+      static constexpr std::size_t maxFields = 80;
+
+      std::string_view sentence;
+      std::string_view format;
+      std::size_t      fieldCount = 0;
+
+      std::uint8_t declaredChecksum = 0;
+      std::uint8_t computedChecksum = 0;
+
+      // delimiters[i] is the offset of the ',' preceding field i;
+      // delimiters[fieldCount] is the offset of the '*'.
+      std::array<std::uint32_t, maxFields + 1> delimiters;
+
+      bool hasValidChecksum() const { return declaredChecksum == computedChecksum; }
+
+      bool allFieldsRecorded() const { return fieldCount <= maxFields; }
+
+      /* The content of field i, excluding the separating commas.
+       * Pre-condition: i < fieldCount and i < maxFields.
+       */
+      std::string_view field(std::size_t i) const
+      {
+          const std::size_t start = delimiters[i] + 1;
+          return sentence.substr(start, delimiters[i + 1] - start);
+      }
+  };
+
+
+  /* Scans a candidate NMEA sentence, checking the "$GP" prefix, the format ID, the
+   * reserved characters and the checksum, and recording the offsets of the data fields
+   * in 'view'.  The bytes are scanned by the kernels selected in scanKernels.h, and no
+   * memory is allocated.
+   *
+   * Sentences with more than SentenceView::maxFields fields are still scanned in full, and
+   * are 'ok' if otherwise valid, but only the offsets of the first 'maxFields' fields are
+   * recorded; see SentenceView::allFieldsRecorded().
+   */
+  ScanStatus scanSentence(std::string_view, SentenceView & view);
+
+
+  // True if the status describes a well-formed sentence (whether or not its checksum is valid).
+  inline bool isWellFormed(ScanStatus status)
+  {
+      return status == ScanStatus::ok || status == ScanStatus::checksumMismatch;
+  }
+}
+
+#endif
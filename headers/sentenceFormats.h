@@ -0,0 +1,118 @@
+#ifndef SENTENCEFORMATS_H_171026
+#define SENTENCEFORMATS_H_171026
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace NMEA
+{
+  // The character classes of the data fields accepted by routeFromLog.
+  enum class FieldClass
+  {
+      decimal,       // at least one character, of which at most one is not a digit
+      signedDecimal, // a decimal, optionally preceded by '-'
+      digits,        // zero or more digits
+      empty,         // no characters
+      north,         // "N"
+      west,          // "W"
+      eastWest,      // "E" or "W"
+      status,        // "A" (active) or "V" (void)
+      mode,          // "A" or "W"
+      metres         // "M"
+  };
+
+
+  /* Packs a three-character sentence format ID (e.g. "GLL") into an integer, so that
+   * formats can be dispatched with a switch rather than by string comparisons.
+   *
+   * Pre-condition: the format is three characters long.
+   */
+  constexpr std::uint32_t formatCode(std::string_view format)
+  {
+      return std::uint32_t(std::uint8_t(format[0])) << 16
+           | std::uint32_t(std::uint8_t(format[1])) << 8
+           | std::uint32_t(std::uint8_t(format[2]));
+  }
+
+
+  /* The layout of a supported sentence format: the number of data fields, the class of
+   * characters expected in each, and the indices of the fields that make up a Position.
+   */
+  struct SentenceFormat
+  {
+      // The index of a field that the format does not have.
+      static constexpr std::size_t noField = std::size_t(-1);
+
+      std::uint32_t code;
+      std::size_t   fieldCount;
+
+      std::size_t time;       // hhmmss.ss
+      std::size_t latitude;   // DDM
+      std::size_t northSouth; // "N" or "S"
+      std::size_t longitude;  // DDM
+      std::size_t eastWest;   // "E" or "W"
+      std::size_t elevation;  // metres, or noField if the format has no elevation
+
+      const FieldClass * fieldClasses; // 'fieldCount' classes, one per field
+
+      constexpr bool hasElevation() const { return elevation != noField; }
+  };
+
+
+  namespace Formats
+  {
+    using FC = FieldClass;
+
+    inline constexpr FieldClass GLL_FIELDS[] = { FC::decimal, FC::north, FC::decimal, FC::west, FC::digits };
+
+    inline constexpr FieldClass RMC_FIELDS[] = { FC::decimal, FC::status, FC::decimal, FC::north, FC::decimal,
+                                                 FC::eastWest, FC::decimal, FC::decimal, FC::digits, FC::empty,
+                                                 FC::mode };
+
+    inline constexpr FieldClass GGA_FIELDS[] = { FC::decimal, FC::decimal, FC::north, FC::decimal, FC::west,
+                                                 FC::digits, FC::digits, FC::empty, FC::signedDecimal,
+                                                 FC::metres, FC::empty, FC::metres, FC::empty, FC::empty };
+
+    // Geographic position (latitude/longitude): lat, N/S, lon, E/W, time
+    inline constexpr SentenceFormat GLL = { formatCode("GLL"), std::size(GLL_FIELDS),
+                                            4, 0, 1, 2, 3, SentenceFormat::noField, GLL_FIELDS };
+
+    // Recommended minimum specific data: time, status, lat, N/S, lon, E/W, speed, course, date, ...
+    inline constexpr SentenceFormat RMC = { formatCode("RMC"), std::size(RMC_FIELDS),
+                                            0, 2, 3, 4, 5, SentenceFormat::noField, RMC_FIELDS };
+
+    // Fix data: time, lat, N/S, lon, E/W, quality, satellites, HDOP, altitude, ...
+    inline constexpr SentenceFormat GGA = { formatCode("GGA"), std::size(GGA_FIELDS),
+                                            0, 1, 2, 3, 4, 8, GGA_FIELDS };
+  }
+
+
+  // Carries a SentenceFormat as a compile-time constant, so that decoders can be specialised for it.
+  template <const SentenceFormat * format>
+  using FormatTag = std::integral_constant<const SentenceFormat *, format>;
+
+
+  /* Calls visitor(FormatTag<&F>()) for the supported format F with the given code, or
+   * unsupported() if there is no such format, and returns the result.  Both must return
+   * the same type.
+   *
+   * To support a new format (e.g. GNS), add its descriptor to Formats and a case here;
+   * each existing format keeps its own specialised decoder.
+   */
+  template <typename Visitor, typename Unsupported>
+  decltype(auto) dispatchFormat(std::uint32_t code, Visitor && visitor, Unsupported && unsupported)
+  {
+      switch (code)
+      {
+          case Formats::GLL.code: return visitor(FormatTag<&Formats::GLL>());
+          case Formats::RMC.code: return visitor(FormatTag<&Formats::RMC>());
+          case Formats::GGA.code: return visitor(FormatTag<&Formats::GGA>());
+          default:                return unsupported();
+      }
+  }
+}
+
+#endif
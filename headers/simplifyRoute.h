@@ -0,0 +1,78 @@
+#ifndef SIMPLIFYROUTE_H_171026
+#define SIMPLIFYROUTE_H_171026
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "parseNMEA.h"
+#include "position.h"
+#include "types.h"
+
+namespace GPS
+{
+  /* The distance (as Position::distanceBetween()) from a Position to the nearest point of
+   * the segment between two others.  The nearest point is found in a local projection
+   * scaled by Earth::latitudeSubtendedBy() and Earth::longitudeSubtendedBy(), which is
+   * accurate for segments much shorter than the Earth's radius.
+   */
+  metres distanceFromSegment(const Position &, const Position & start, const Position & end);
+}
+
+namespace NMEA
+{
+  /* Simplifies a route by the Douglas-Peucker algorithm, keeping the first and last
+   * positions and as few others as needed for every discarded position to lie within
+   * 'tolerance' metres (see GPS::distanceFromSegment()) of the simplified route segment
+   * that replaced it.
+   *
+   * Throws a std::invalid_argument exception if the tolerance is negative.
+   */
+  Route simplifyRoute(const Route &, GPS::metres tolerance);
+
+
+  /* Simplifies a stream of positions with the same maximum deviation as simplifyRoute(),
+   * but in bounded memory, so that it can be filled directly by appendRouteFromLog().
+   *
+   * The first position is always kept.  Each kept position starts a window of later
+   * positions, which grows while every position within it lies within the tolerance of
+   * the segment from the kept position to the newest one.  When a position breaks the
+   * tolerance, the previous one is kept and starts the next window.  A window that
+   * reaches 'windowSize' positions is closed by keeping its newest position, so at most
+   * 'windowSize' positions are held, and each is compared with at most that many.
+   *
+   * The callback is invoked with each position as soon as it is known to be kept.
+   */
+  class StreamSimplifier
+  {
+    public:
+
+      using Callback = std::function<void(const GPS::Position &)>;
+
+      static constexpr std::size_t defaultWindowSize = 256;
+
+      /* Throws a std::invalid_argument exception if the tolerance is negative or the
+       * window size is zero.
+       */
+      StreamSimplifier(GPS::metres tolerance, Callback, std::size_t windowSize = defaultWindowSize);
+
+      // Add the next position of the route.
+      void push_back(const GPS::Position &);
+
+      // Keep the final position of the route, and start afresh.
+      void finish();
+
+    private:
+      bool withinTolerance(const GPS::Position & end) const;
+      void keepNewest();
+
+      GPS::metres tolerance;
+      Callback onKept;
+      std::size_t windowSize;
+      std::optional<GPS::Position> anchor;
+      std::vector<GPS::Position> window;
+  };
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef SPATIALINDEX_H_171026
+#define SPATIALINDEX_H_171026
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "parseNMEA.h"
+#include "position.h"
+#include "types.h"
+
+namespace NMEA
+{
+  /* A bulk-built spatial index over the positions and segments of one or more Routes,
+   * answering nearest-point, k-nearest and radius queries.
+   *
+   * The index is a grid of latitude/longitude cells at least 'cellSize' metres across
+   * (with widths found by Earth::longitudeSubtendedBy() at the highest latitude of the
+   * routes).  The occupied cells are held in one array in Z-order (interleaving the bits of
+   * their row and column numbers), so that every aligned square block of 2^n by 2^n cells
+   * is a contiguous range of the array, which is thereby an implicit quadtree.  Queries
+   * visit the occupied blocks nearest first, by the great-circle distance to their bounds,
+   * splitting each into its occupied quarters, and stop once the next block is further
+   * away than the matches found (or the radius).  Each segment is held in the cells that
+   * it crosses or, if it crosses more than a few, in the blocks of cells that it crosses at
+   * the smallest level of blocks at which they are few, so that any segment takes only
+   * constant time and space to index, and is found by a query in only a few places.
+   *
+   * Distances are those of Position::distanceBetween() for positions, and of
+   * GPS::distanceFromSegment() for segments.  The index refers to the routes, which must
+   * outlive it and must not be modified while it is in use.
+   */
+  class SpatialIndex
+  {
+    public:
+
+      // A position within the indexed routes, or the segment that starts there.
+      struct Entry
+      {
+          std::size_t route;
+          std::size_t index;
+
+          bool operator==(const Entry & other) const { return route == other.route && index == other.index; }
+      };
+
+      struct Match
+      {
+          Entry       entry;
+          GPS::metres distance;
+      };
+
+      // The work done by queries, which add to these counts when given a QueryStats.
+      struct QueryStats
+      {
+          std::size_t blocks = 0;    // the blocks of cells visited (of any size)
+          std::size_t distances = 0; // the distances computed to positions or segments
+      };
+
+      static constexpr GPS::metres defaultCellSize = 100;
+
+      /* Throws a std::invalid_argument exception if the cell size is less than 1 metre,
+       * which keeps the keys of the cells (interleaving the bits of their row and column
+       * numbers) within 64 bits.
+       */
+      explicit SpatialIndex(const Route &, GPS::metres cellSize = defaultCellSize);
+      explicit SpatialIndex(const std::vector<Route> &, GPS::metres cellSize = defaultCellSize);
+
+      const GPS::Position & position(Entry) const;
+
+      // The positions within 'radius' metres, nearest first.
+      std::vector<Match> pointsWithin(const GPS::Position &, GPS::metres radius, QueryStats * = nullptr) const;
+
+      // The nearest position, or none if the routes are empty.
+      std::optional<Match> nearestPoint(const GPS::Position &, QueryStats * = nullptr) const;
+
+      // The k nearest positions (or all of them, if there are fewer), nearest first.
+      std::vector<Match> nearestPoints(const GPS::Position &, std::size_t k, QueryStats * = nullptr) const;
+
+      // The segments with some point within 'radius' metres, nearest first.
+      std::vector<Match> segmentsWithin(const GPS::Position &, GPS::metres radius, QueryStats * = nullptr) const;
+
+      // The nearest segment, or none if no route has more than one position.
+      std::optional<Match> nearestSegment(const GPS::Position &, QueryStats * = nullptr) const;
+
+    private:
+
+      // The occupied cells and blocks of cells, sorted by key, with an entry for each point or
+      // segment in them.
+      struct Cells
+      {
+          std::vector<std::uint64_t> keys;
+          std::vector<Entry>         entries;
+      };
+
+      // An aligned block of 2^level by 2^level cells, starting at the cell whose interleaved row
+      // and column numbers are 'firstCell', whose entries are entries[first] to entries[last - 1]
+      // of a Cells.
+      struct Block
+      {
+          GPS::metres   distance; // a lower bound on the distance to any position in the block
+          int           level;
+          std::uint64_t firstCell;
+          std::size_t   first, last;
+      };
+
+      void build(GPS::metres cellSize);
+
+      long row(GPS::degrees lat) const;
+      long column(GPS::degrees lon) const;
+
+      /* The row and column numbers of the first cell of the block of 2^level by 2^level cells
+       * that holds the given cell, with their bits interleaved, followed by the level, so that
+       * larger blocks precede the smaller blocks within them.
+       */
+      std::uint64_t key(long row, long column, int level) const;
+
+      // The smallest block that holds the occupied cells from 'first' to 'last - 1'.
+      Block block(const Cells &, const GPS::Position &, std::size_t first, std::size_t last) const;
+
+      GPS::metres distanceToBlock(const GPS::Position &, int level, std::uint64_t firstCell) const;
+
+      // Visits the entries of the blocks in order of their distance, until done(distance) is
+      // true of the distance to the next block.
+      template <typename Visitor, typename Done>
+      void visitNearestFirst(const Cells &, const GPS::Position &, Visitor &, Done &, QueryStats *) const;
+
+      const GPS::Position & segmentEnd(Entry) const;
+
+      std::vector<const Route *> routes;
+
+      GPS::degrees cellLatitude, cellLongitude, maxLatitude;
+      long rowCount, columnCount;
+
+      Cells points;
+      Cells segments;
+  };
+}
+
+#endif
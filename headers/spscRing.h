@@ -0,0 +1,140 @@
+#ifndef SPSCRING_H_171026
+#define SPSCRING_H_171026
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace NMEA
+{
+  /* A bounded lock-free queue between exactly one producer thread and one consumer thread.
+   *
+   * The producer only writes 'tail' and the consumer only writes 'head', each with release
+   * ordering after moving an element, so neither side takes a lock to push or pop.  The two
+   * indices are on separate cache lines so that the threads do not contend for one line.
+   *
+   * push() and pop() wait while the ring is full or empty: briefly by yielding to other
+   * threads, then by blocking on a condition variable, so that a side left idle for long
+   * (e.g. parsers waiting on a slow stream) uses no CPU.  A waiting side registers itself
+   * before its final check, and the other side notifies it only when one is registered, so
+   * the lock is taken only when a thread is, or is about to be, asleep.
+   */
+  template <typename T>
+  class SPSCRing
+  {
+    public:
+
+      // Throws a std::invalid_argument exception if the capacity is 0.
+      explicit SPSCRing(std::size_t capacity)
+          : slots(capacity)
+      {
+        if (capacity == 0)
+          throw std::invalid_argument("The capacity of a ring must be positive.");
+      }
+
+      SPSCRing(const SPSCRing &) = delete;
+      SPSCRing & operator=(const SPSCRing &) = delete;
+
+      std::size_t capacity() const { return slots.size(); }
+
+      // Moves the value into the ring, unless it is full.  Producer only.
+      bool tryPush(T & value)
+      {
+        if (!pushIfSpace(value))
+          return false;
+        wakeWaiter();
+        return true;
+      }
+
+      // Moves the oldest value out of the ring, unless it is empty.  Consumer only.
+      bool tryPop(T & value)
+      {
+        if (!popIfAny(value))
+          return false;
+        wakeWaiter();
+        return true;
+      }
+
+      void push(T value)
+      {
+        waitUntil([&] { return pushIfSpace(value); });
+      }
+
+      T pop()
+      {
+        T value;
+        waitUntil([&] { return popIfAny(value); });
+        return value;
+      }
+
+    private:
+      static constexpr std::size_t CACHE_LINE = 64;
+
+      // The number of times to yield before blocking.
+      static constexpr int SPIN_LIMIT = 64;
+
+      bool pushIfSpace(T & value)
+      {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+          return false;
+        slots[t % slots.size()] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool popIfAny(T & value)
+      {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h)
+          return false;
+        value = std::move(slots[h % slots.size()]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Repeats the attempt until it succeeds, then wakes the other side if it is waiting.
+      template <typename Attempt>
+      void waitUntil(Attempt attempt)
+      {
+        bool done = false;
+        for (int spin = 0; spin < SPIN_LIMIT && !(done = attempt()); ++spin)
+          std::this_thread::yield();
+
+        if (!done) {
+          std::unique_lock<std::mutex> lock(mutex);
+          waiters.fetch_add(1, std::memory_order_relaxed);
+          // Pairs with the fence in wakeWaiter(): either the attempt below sees the other
+          // side's move, or the other side sees this waiter and notifies it.
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          changed.wait(lock, attempt);
+          waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+        wakeWaiter();
+      }
+
+      void wakeWaiter()
+      {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+          const std::lock_guard<std::mutex> lock(mutex);
+          changed.notify_all();
+        }
+      }
+
+      std::vector<T> slots;
+      alignas(CACHE_LINE) std::atomic<std::size_t> head{0}; // the next slot to pop
+      alignas(CACHE_LINE) std::atomic<std::size_t> tail{0}; // the next slot to push
+
+      alignas(CACHE_LINE) std::atomic<int> waiters{0};      // the threads blocked, or about to block
+      std::mutex mutex;
+      std::condition_variable changed;
+  };
+}
+
+#endif
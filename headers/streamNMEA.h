@@ -0,0 +1,57 @@
+#ifndef STREAMNMEA_H_171026
+#define STREAMNMEA_H_171026
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+#include "parseNMEA.h"
+#include "position.h"
+
+namespace NMEA
+{
+  /* An incremental parser for a live stream of NMEA sentences (one sentence per line).
+   *
+   * Bytes may be fed in chunks of any size.  As soon as a line is complete, it is parsed
+   * as by routeFromLog(), and if it contains a valid sentence the callback is invoked
+   * with its Position.  Lines without valid sentences, including those whose data
+   * cannot be converted to a Position, are ignored.
+   *
+   * Partial lines are held in a small fixed buffer between calls, so memory use does not
+   * grow with the length of the stream.  Lines too long for the buffer cannot be valid
+   * NMEA 0183 sentences (which are at most 82 characters), and are discarded.
+   */
+  class StreamParser
+  {
+    public:
+
+      using Callback = std::function<void(const GPS::Position &)>;
+
+      static constexpr std::size_t bufferSize = 128;
+
+      explicit StreamParser(Callback);
+
+      // Parse the next chunk of the stream.
+      void feed(const char * data, std::size_t length);
+      void feed(std::string_view);
+
+      // Parse any final line that was not terminated by a newline, e.g. when the stream closes.
+      void finish();
+
+      // The number of lines discarded because they did not fit in the buffer.
+      std::size_t overlongLines() const;
+
+    private:
+      void parseLine(std::string_view);
+
+      Callback onPosition;
+      ParserContext context;
+      std::array<char, bufferSize> partial;
+      std::size_t partialLength;
+      bool discarding;
+      std::size_t discarded;
+  };
+}
+
+#endif
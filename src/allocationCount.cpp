@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocationCount.h"
+
+std::atomic<std::size_t> allocationCount(0);
+
+/* The complete set of replaceable allocation and deallocation functions is defined here, in
+ * its own translation unit, so that every form of new is paired with a matching delete and
+ * the compiler never sees a std::malloc'd pointer reach a mismatched deallocation.
+ */
+namespace
+{
+  void * allocate(std::size_t size) noexcept
+  {
+      ++allocationCount;
+      return std::malloc(size == 0 ? 1 : size);
+  }
+
+  void * allocate(std::size_t size, std::align_val_t alignment) noexcept
+  {
+      ++allocationCount;
+      // std::aligned_alloc requires the size to be a multiple of the alignment.
+      const std::size_t align = static_cast<std::size_t>(alignment);
+      const std::size_t rounded = ((size == 0 ? 1 : size) + align - 1) / align * align;
+      return std::aligned_alloc(align, rounded);
+  }
+}
+
+void * operator new(std::size_t size)
+{
+    if (void * ptr = allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+    if (void * ptr = allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void * ptr = allocate(size, alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (void * ptr = allocate(size, alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void operator delete(void * ptr) noexcept                                { std::free(ptr); }
+void operator delete[](void * ptr) noexcept                              { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept                   { std::free(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept                 { std::free(ptr); }
+void operator delete(void * ptr, const std::nothrow_t &) noexcept        { std::free(ptr); }
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept      { std::free(ptr); }
+void operator delete(void * ptr, std::align_val_t) noexcept              { std::free(ptr); }
+void operator delete[](void * ptr, std::align_val_t) noexcept            { std::free(ptr); }
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept   { std::free(ptr); }
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::align_val_t, const std::nothrow_t &) noexcept   { std::free(ptr); }
+void operator delete[](void * ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
@@ -0,0 +1,186 @@
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include "binaryRoute.h"
+
+namespace NMEA
+{
+  namespace
+  {
+    const char MAGIC[8] = { 'N', 'M', 'E', 'A', 'R', 'O', 'U', 'T' };
+    const std::uint32_t VERSION = 1;
+    const std::size_t HEADER_SIZE = sizeof(MAGIC) + 4 + 4 + 8 + 8;
+
+    void appendLittleEndian(std::string & buffer, std::uint64_t value, std::size_t bytes)
+    {
+      for (std::size_t i = 0; i < bytes; ++i)
+        buffer.push_back(char(value >> (8 * i)));
+    }
+
+    std::uint64_t readLittleEndian(const char * data, std::size_t bytes)
+    {
+      std::uint64_t value = 0;
+      for (std::size_t i = 0; i < bytes; ++i)
+        value |= std::uint64_t(static_cast<unsigned char>(data[i])) << (8 * i);
+      return value;
+    }
+
+    void appendVarint(std::string & buffer, std::int64_t value)
+    {
+      // Zig-zag encoding maps small negative values to small unsigned values.
+      std::uint64_t zigzag = (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+      while (zigzag >= 0x80) {
+        buffer.push_back(char(zigzag | 0x80));
+        zigzag >>= 7;
+      }
+      buffer.push_back(char(zigzag));
+    }
+
+    std::int64_t toFixedPoint(double value, double unitsPerValue)
+    {
+      return std::llround(value * unitsPerValue);
+    }
+
+    void corrupt(const std::string & path, const std::string & problem)
+    {
+      throw std::runtime_error("Corrupt binary route " + path + ": " + problem);
+    }
+  }
+
+  void writeBinaryRoute(std::ostream & out, const Route & route, std::size_t blockSize)
+  {
+    if (blockSize == 0)
+      throw std::invalid_argument("The block size of a binary route must be positive.");
+    if (blockSize > UINT32_MAX)
+      throw std::invalid_argument("The block size of a binary route must fit in 32 bits.");
+
+    std::string buffer(MAGIC, sizeof(MAGIC));
+    appendLittleEndian(buffer, VERSION, 4);
+    appendLittleEndian(buffer, blockSize, 4);
+    appendLittleEndian(buffer, route.size(), 8);
+    appendLittleEndian(buffer, 0, 8); // the index offset, filled in below
+
+    std::vector<std::uint64_t> blockOffsets;
+    std::int64_t lat = 0, lon = 0, ele = 0;
+    for (std::size_t i = 0; i < route.size(); ++i) {
+      if (i % blockSize == 0) {
+        blockOffsets.push_back(buffer.size());
+        lat = lon = ele = 0;
+      }
+
+      const GPS::Position & pos = route[i];
+      if (!(std::fabs(pos.elevation()) < BinaryRoute::maxElevation))
+        throw std::invalid_argument("Elevation out of range for a binary route.");
+      const std::int64_t nextLat = toFixedPoint(pos.latitude(), BinaryRoute::unitsPerDegree);
+      const std::int64_t nextLon = toFixedPoint(pos.longitude(), BinaryRoute::unitsPerDegree);
+      const std::int64_t nextEle = toFixedPoint(pos.elevation(), BinaryRoute::unitsPerMetre);
+      appendVarint(buffer, nextLat - lat);
+      appendVarint(buffer, nextLon - lon);
+      appendVarint(buffer, nextEle - ele);
+      lat = nextLat;
+      lon = nextLon;
+      ele = nextEle;
+    }
+
+    const std::uint64_t indexOffset = buffer.size();
+    for (std::uint64_t offset : blockOffsets)
+      appendLittleEndian(buffer, offset, 8);
+    for (std::size_t i = 0; i < 8; ++i)
+      buffer[HEADER_SIZE - 8 + i] = char(indexOffset >> (8 * i));
+
+    if (!out.write(buffer.data(), buffer.size()))
+      throw std::runtime_error("Cannot write binary route.");
+  }
+
+  void writeBinaryRouteFile(const std::string & path, const Route & route, std::size_t blockSize)
+  {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+      throw std::runtime_error("Cannot create " + path);
+    writeBinaryRoute(out, route, blockSize);
+    out.close();
+    if (!out)
+      throw std::runtime_error("Cannot write " + path);
+  }
+
+  BinaryRouteFile::BinaryRouteFile(const std::string & path)
+      : file(path)
+  {
+    const char * data = file.data();
+    if (file.size() < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+      corrupt(path, "missing header");
+    if (readLittleEndian(data + 8, 4) != VERSION)
+      corrupt(path, "unsupported version");
+
+    positionsPerBlock = readLittleEndian(data + 12, 4);
+    positionCount = readLittleEndian(data + 16, 8);
+    indexOffset = readLittleEndian(data + 24, 8);
+    if (positionsPerBlock == 0)
+      corrupt(path, "zero block size");
+    blocks = positionCount / positionsPerBlock + (positionCount % positionsPerBlock != 0);
+
+    // Check the index once, so that blocks can be decoded without further checks on their bounds.
+    if (indexOffset < HEADER_SIZE || indexOffset > file.size() || (file.size() - indexOffset) / 8 != blocks
+        || (file.size() - indexOffset) % 8 != 0)
+      corrupt(path, "invalid index");
+    std::uint64_t previous = HEADER_SIZE;
+    for (std::size_t block = 0; block < blocks; ++block) {
+      const std::uint64_t offset = blockOffset(block);
+      if (offset < previous || offset > indexOffset || (block == 0 && offset != HEADER_SIZE))
+        corrupt(path, "invalid block offset");
+      previous = offset;
+    }
+  }
+
+  std::size_t BinaryRouteFile::size() const
+  {
+    return positionCount;
+  }
+
+  std::size_t BinaryRouteFile::blockSize() const
+  {
+    return positionsPerBlock;
+  }
+
+  std::size_t BinaryRouteFile::blockCount() const
+  {
+    return blocks;
+  }
+
+  std::uint64_t BinaryRouteFile::blockOffset(std::size_t block) const
+  {
+    return readLittleEndian(file.data() + indexOffset + 8 * block, 8);
+  }
+
+  GPS::Position BinaryRouteFile::operator[](std::size_t index) const
+  {
+    if (index >= positionCount)
+      throw std::out_of_range("Binary route index out of range.");
+
+    std::optional<GPS::Position> ret;
+    std::size_t remaining = index % positionsPerBlock;
+    decodeBlock(index / positionsPerBlock, [&](const GPS::Position & pos) {
+      if (remaining-- > 0)
+        return true;
+      ret = pos;
+      return false;
+    });
+    return *ret;
+  }
+
+  Route BinaryRouteFile::toRoute() const
+  {
+    Route ret;
+    ret.reserve(positionCount);
+    appendTo(ret);
+    return ret;
+  }
+
+  Route routeFromBinaryFile(const std::string & path)
+  {
+    return BinaryRouteFile(path).toRoute();
+  }
+}
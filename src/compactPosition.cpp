@@ -0,0 +1,54 @@
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "compactPosition.h"
+
+namespace GPS
+{
+  namespace
+  {
+      std::int32_t toUnits(double value, double unitsPerValue)
+      {
+          return static_cast<std::int32_t>(std::lround(value * unitsPerValue));
+      }
+
+      // Elevations beyond this many metres overflow 32 bits of decimetres.
+      const metres MAX_ELEVATION = std::numeric_limits<std::int32_t>::max() / CompactPosition::unitsPerMetre;
+  }
+
+  CompactPosition::CompactPosition(const Position & pos)
+      : lat(toUnits(pos.latitude(), unitsPerDegree)),
+        lon(toUnits(pos.longitude(), unitsPerDegree)),
+        ele(0)
+  {
+      if (!(std::fabs(pos.elevation()) < MAX_ELEVATION))
+          throw std::invalid_argument("Elevation out of range for a CompactPosition.");
+      ele = toUnits(pos.elevation(), unitsPerMetre);
+  }
+
+  CompactPosition::operator Position() const
+  {
+      return Position(latitude(), longitude(), elevation());
+  }
+
+  degrees CompactPosition::latitude() const
+  {
+      return lat / unitsPerDegree;
+  }
+
+  degrees CompactPosition::longitude() const
+  {
+      return lon / unitsPerDegree;
+  }
+
+  metres CompactPosition::elevation() const
+  {
+      return ele / unitsPerMetre;
+  }
+
+  metres CompactPosition::distanceBetween(CompactPosition p1, CompactPosition p2)
+  {
+      return Position::distanceBetween(p1, p2);
+  }
+}
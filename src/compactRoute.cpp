@@ -0,0 +1,61 @@
+#include "compactRoute.h"
+
+namespace NMEA
+{
+  CompactRoute::CompactRoute(const Route & route)
+  {
+    reserve(route.size());
+    for (const GPS::Position & pos : route)
+      push_back(pos);
+  }
+
+  std::size_t CompactRoute::size() const
+  {
+    return positions.size();
+  }
+
+  bool CompactRoute::empty() const
+  {
+    return positions.empty();
+  }
+
+  void CompactRoute::reserve(std::size_t n)
+  {
+    positions.reserve(n);
+  }
+
+  void CompactRoute::clear()
+  {
+    positions.clear();
+  }
+
+  void CompactRoute::push_back(const GPS::Position & pos)
+  {
+    positions.emplace_back(pos);
+  }
+
+  void CompactRoute::push_back(GPS::CompactPosition pos)
+  {
+    positions.push_back(pos);
+  }
+
+  GPS::CompactPosition CompactRoute::operator[](std::size_t i) const
+  {
+    return positions[i];
+  }
+
+  CompactRoute::const_iterator CompactRoute::begin() const
+  {
+    return positions.begin();
+  }
+
+  CompactRoute::const_iterator CompactRoute::end() const
+  {
+    return positions.end();
+  }
+
+  Route CompactRoute::toRoute() const
+  {
+    return Route(begin(), end());
+  }
+}
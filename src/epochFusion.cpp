@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstring>
+
+#include "epochFusion.h"
+#include "sentenceFormats.h"
+
+namespace NMEA
+{
+  namespace
+  {
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    unsigned int twoDigits(std::string_view digits)
+    {
+      return (digits[0] - '0') * 10 + (digits[1] - '0');
+    }
+
+    // The format of the (pre-conditionally supported) sentence data.
+    const SentenceFormat & formatOf(const SentenceData & data)
+    {
+      return *dispatchFormat(formatCode(data.first),
+                             [](auto format) { return format(); },
+                             []() -> const SentenceFormat * { return nullptr; });
+    }
+  }
+
+  bool parseTimeOfDay(std::string_view field, GPS::seconds & time)
+  {
+    // The hhmmss digits, followed by an optional fraction of at least one digit.
+    const std::size_t point = field.find('.');
+    std::string_view hhmmss = field.substr(0, point);
+    if (point != std::string_view::npos) {
+      const std::string_view fraction = field.substr(point + 1);
+      if (fraction.empty() || !std::all_of(fraction.begin(), fraction.end(), isDigit))
+        return false;
+    }
+
+    if (hhmmss.length() < 5 || hhmmss.length() > 6 || !std::all_of(hhmmss.begin(), hhmmss.end(), isDigit))
+      return false;
+
+    const unsigned int hours = hhmmss.length() == 5 ? hhmmss[0] - '0' : twoDigits(hhmmss);
+    hhmmss.remove_prefix(hhmmss.length() - 4);
+    const unsigned int minutes = twoDigits(hhmmss), secs = twoDigits(hhmmss.substr(2));
+
+    // Allow for a leap second.
+    if (hours > 23 || minutes > 59 || secs > 60)
+      return false;
+
+    time = hours * 3600ull + minutes * 60ull + secs;
+    return true;
+  }
+
+  std::optional<Fix> EpochFusion::add(const SentenceData & data, const GPS::Position & pos)
+  {
+    const SentenceFormat & format = formatOf(data);
+    const std::string & timeField = data.second[format.time];
+
+    // Another sentence of the pending epoch.
+    if (pending && timeField == pendingTimeField) {
+      if (format.hasElevation() && !pendingHasElevation) {
+        const GPS::Position & fused = pending->position;
+        pending->position = GPS::Position(fused.latitude(), fused.longitude(), pos.elevation());
+        pendingHasElevation = true;
+      }
+      return std::nullopt;
+    }
+
+    GPS::seconds time;
+    if (!parseTimeOfDay(timeField, time))
+      return std::nullopt;
+
+    std::optional<Fix> completed = std::move(pending);
+    pending = Fix{time, pos};
+    pendingTimeField.assign(timeField);
+    pendingHasElevation = format.hasElevation();
+    return completed;
+  }
+
+  std::optional<Fix> EpochFusion::finish()
+  {
+    std::optional<Fix> completed = std::move(pending);
+    pending.reset();
+    pendingTimeField.clear();
+    pendingHasElevation = false;
+    return completed;
+  }
+
+  namespace
+  {
+    void addFix(Track & track, std::optional<Fix> fix)
+    {
+      if (fix)
+        track.push_back(*fix);
+    }
+  }
+
+  Track trackFromLog(std::istream & fs)
+  {
+    Track ret;
+    ParserContext context;
+    EpochFusion fusion;
+    while (context.readLine(fs)) {
+      if (std::optional<GPS::Position> pos = context.parseLine())
+        addFix(ret, fusion.add(context.sentenceData(), *pos));
+    }
+    addFix(ret, fusion.finish());
+    return ret;
+  }
+
+  Track trackFromLogBuffer(std::string_view log)
+  {
+    Track ret;
+    ParserContext context;
+    EpochFusion fusion;
+    while (!log.empty()) {
+      const char * newline = static_cast<const char *>(std::memchr(log.data(), '\n', log.size()));
+      const std::size_t lineLength = newline ? newline - log.data() : log.size();
+      if (std::optional<GPS::Position> pos = context.parseLine(log.substr(0, lineLength)))
+        addFix(ret, fusion.add(context.sentenceData(), *pos));
+      log.remove_prefix(newline ? lineLength + 1 : lineLength);
+    }
+    addFix(ret, fusion.finish());
+    return ret;
+  }
+}
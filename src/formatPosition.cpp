@@ -0,0 +1,132 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "formatPosition.h"
+
+namespace GPS
+{
+  namespace
+  {
+      /* Each append function writes at 'first', returning a pointer past the characters
+       * written, or nullptr if they do not fit (or if 'first' is already nullptr).
+       */
+
+      char * appendText(char * first, char * last, std::string_view text)
+      {
+          if (!first || std::size_t(last - first) < text.size())
+              return nullptr;
+          std::memcpy(first, text.data(), text.size());
+          return first + text.size();
+      }
+
+      char * appendNumber(char * first, char * last, double value, int precision)
+      {
+          if (!first)
+              return nullptr;
+          const std::to_chars_result result = precision == PositionFormat::shortest
+              ? std::to_chars(first, last, value)
+              : std::to_chars(first, last, value, std::chars_format::fixed, precision);
+          return result.ec == std::errc() ? result.ptr : nullptr;
+      }
+
+      // Appends the digits of a value, with leading zeros up to the given width.
+      char * appendPadded(char * first, char * last, std::uint64_t value, int width)
+      {
+          char digits[20];
+          const std::size_t count = std::to_chars(digits, digits + sizeof(digits), value).ptr - digits;
+          const std::size_t padding = count < std::size_t(width) ? width - count : 0;
+          if (!first || std::size_t(last - first) < padding + count)
+              return nullptr;
+          std::memset(first, '0', padding);
+          std::memcpy(first + padding, digits, count);
+          return first + padding + count;
+      }
+
+      /* Appends an angle as unsigned DDM, with the given number of degree digits, followed
+       * by a comma and its positive or negative bearing character.
+       */
+      char * appendDDM(char * first, char * last, degrees angle, int degreeDigits, int precision,
+                       char positive, char negative)
+      {
+          std::uint64_t scale = 1;
+          for (int i = 0; i < precision; ++i)
+              scale *= 10;
+
+          // Round the whole angle, so that minutes which round up to 60 carry into the degrees.
+          const std::uint64_t units = std::llround(std::abs(angle) * 60 * scale);
+          const std::uint64_t minuteUnits = units % (60 * scale);
+
+          first = appendPadded(first, last, units / (60 * scale), degreeDigits);
+          first = appendPadded(first, last, minuteUnits / scale, 2);
+          if (precision > 0)
+          {
+              first = appendText(first, last, ".");
+              first = appendPadded(first, last, minuteUnits % scale, precision);
+          }
+          first = appendText(first, last, ",");
+          const char bearing = angle < 0 && units != 0 ? negative : positive;
+          return appendText(first, last, std::string_view(&bearing, 1));
+      }
+
+      const int NMEA_MINUTE_DECIMALS = 4;
+  }
+
+  std::to_chars_result formatPosition(char * first, char * last, const Position & pos, const PositionFormat & format)
+  {
+      if (format.precision < PositionFormat::shortest || format.precision > PositionFormat::maxPrecision)
+          throw std::invalid_argument("The precision of a formatted Position must not exceed "
+                                      + std::to_string(PositionFormat::maxPrecision) + " decimal places.");
+
+      const int precision = format.precision;
+      char * next = first;
+      switch (format.layout)
+      {
+          case PositionLayout::attributes:
+              next = appendText(next, last, "lat=\"");
+              next = appendNumber(next, last, pos.latitude(), precision);
+              next = appendText(next, last, "\" lon=\"");
+              next = appendNumber(next, last, pos.longitude(), precision);
+              next = appendText(next, last, "\"");
+              if (format.includeElevation)
+              {
+                  next = appendText(next, last, " ele=\"");
+                  next = appendNumber(next, last, pos.elevation(), precision);
+                  next = appendText(next, last, "\"");
+              }
+              break;
+
+          case PositionLayout::csv:
+              next = appendNumber(next, last, pos.latitude(), precision);
+              next = appendText(next, last, ",");
+              next = appendNumber(next, last, pos.longitude(), precision);
+              if (format.includeElevation)
+              {
+                  next = appendText(next, last, ",");
+                  next = appendNumber(next, last, pos.elevation(), precision);
+              }
+              break;
+
+          case PositionLayout::ddm:
+          {
+              const int minuteDecimals = precision == PositionFormat::shortest ? NMEA_MINUTE_DECIMALS : precision;
+              next = appendDDM(next, last, pos.latitude(), 2, minuteDecimals, 'N', 'S');
+              next = appendText(next, last, ",");
+              next = appendDDM(next, last, pos.longitude(), 3, minuteDecimals, 'E', 'W');
+              if (format.includeElevation)
+              {
+                  next = appendText(next, last, ",");
+                  next = appendNumber(next, last, pos.elevation(), precision);
+              }
+              break;
+          }
+      }
+
+      if (!next)
+          return { last, std::errc::value_too_large };
+      return { next, std::errc() };
+  }
+}
@@ -0,0 +1,192 @@
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "gpxReader.h"
+
+namespace GPS
+{
+  namespace
+  {
+      bool isSpace(char c)
+      {
+          return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+      }
+
+      std::string_view trim(std::string_view text)
+      {
+          while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+          while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+          return text;
+      }
+
+      bool startsWith(std::string_view text, std::string_view prefix)
+      {
+          return text.substr(0, prefix.size()) == prefix;
+      }
+
+      // True if the text starts with the element name, followed by the end of the name.
+      bool startsWithName(std::string_view text, std::string_view name)
+      {
+          return startsWith(text, name) && text.size() > name.size()
+              && (isSpace(text[name.size()]) || text[name.size()] == '>' || text[name.size()] == '/');
+      }
+
+      [[noreturn]] void malformed(const std::string & problem)
+      {
+          throw std::invalid_argument("Malformed GPX point: " + problem);
+      }
+
+      double parseNumber(std::string_view text, const char * what)
+      {
+          text = trim(text);
+          double value;
+          const std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+          if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+              malformed(std::string("invalid ") + what + " \"" + std::string(text) + "\"");
+          return value;
+      }
+
+      // Skips past the terminator, throwing if it is missing.
+      void skipPast(std::string_view & text, std::string_view terminator)
+      {
+          const std::size_t end = text.find(terminator);
+          if (end == std::string_view::npos)
+              malformed("unterminated \"" + std::string(terminator) + "\"");
+          text.remove_prefix(end + terminator.size());
+      }
+
+      /* Skips markup that may contain '<' characters, given the text just after a '<'.
+       * Returns false if the text does not start with such markup.
+       */
+      bool skipSpecialMarkup(std::string_view & text)
+      {
+          if (startsWith(text, "!--"))
+              skipPast(text, "-->");
+          else if (startsWith(text, "![CDATA["))
+              skipPast(text, "]]>");
+          else if (startsWith(text, "?"))
+              skipPast(text, "?>");
+          else
+              return false;
+          return true;
+      }
+
+      const std::string_view ROUTE_POINT = "rtept";
+      const std::string_view TRACK_POINT = "trkpt";
+  }
+
+  GPXReader::GPXReader(std::string_view document)
+      : rest(document) {}
+
+  std::optional<Position> GPXReader::next()
+  {
+      while (true)
+      {
+          const char * tag = rest.empty() ? nullptr : static_cast<const char *>(std::memchr(rest.data(), '<', rest.size()));
+          if (!tag)
+          {
+              rest = std::string_view();
+              return std::nullopt;
+          }
+          rest.remove_prefix(tag + 1 - rest.data());
+
+          // Other elements need not be skipped, as '<' cannot appear within their tags.
+          if (startsWithName(rest, ROUTE_POINT))
+              return readPoint(ROUTE_POINT);
+          if (startsWithName(rest, TRACK_POINT))
+              return readPoint(TRACK_POINT);
+          skipSpecialMarkup(rest);
+      }
+  }
+
+  Position GPXReader::readPoint(std::string_view elementName)
+  {
+      rest.remove_prefix(elementName.size());
+
+      // Read the attributes, up to the end of the start tag.
+      std::optional<double> lat, lon;
+      bool empty = false;
+      while (true)
+      {
+          while (!rest.empty() && isSpace(rest.front())) rest.remove_prefix(1);
+          if (rest.empty())
+              malformed("unterminated start tag");
+          if (rest.front() == '>')
+              break;
+          if (startsWith(rest, "/>"))
+          {
+              empty = true;
+              break;
+          }
+
+          const std::size_t equals = rest.find('=');
+          if (equals == std::string_view::npos)
+              malformed("attribute without a value");
+          const std::string_view name = trim(rest.substr(0, equals));
+          rest.remove_prefix(equals + 1);
+          while (!rest.empty() && isSpace(rest.front())) rest.remove_prefix(1);
+          if (rest.empty() || (rest.front() != '"' && rest.front() != '\''))
+              malformed("unquoted attribute value");
+          const std::size_t close = rest.find(rest.front(), 1);
+          if (close == std::string_view::npos)
+              malformed("unterminated attribute value");
+          const std::string_view value = rest.substr(1, close - 1);
+          rest.remove_prefix(close + 1);
+
+          if (name == "lat")
+              lat = parseNumber(value, "latitude");
+          else if (name == "lon")
+              lon = parseNumber(value, "longitude");
+      }
+      rest.remove_prefix(empty ? 2 : 1);
+      if (!lat || !lon)
+          malformed("missing latitude or longitude");
+
+      // Find the elevation among the children, up to the end tag.
+      double ele = 0;
+      while (!empty)
+      {
+          const std::size_t tag = rest.find('<');
+          if (tag == std::string_view::npos)
+              malformed("missing end tag");
+          rest.remove_prefix(tag + 1);
+
+          if (startsWith(rest, "/") && startsWithName(rest.substr(1), elementName))
+          {
+              skipPast(rest, ">");
+              break;
+          }
+          if (startsWithName(rest, "ele"))
+          {
+              skipPast(rest, ">");
+              const std::size_t end = rest.find('<');
+              if (end == std::string_view::npos)
+                  malformed("unterminated elevation");
+              ele = parseNumber(rest.substr(0, end), "elevation");
+              rest.remove_prefix(end);
+          }
+          else
+          {
+              skipSpecialMarkup(rest);
+          }
+      }
+
+      return Position(*lat, *lon, ele);
+  }
+
+  NMEA::Route routeFromGPXBuffer(std::string_view document)
+  {
+      NMEA::Route ret;
+      appendRouteFromGPXBuffer(document, ret);
+      return ret;
+  }
+
+  NMEA::Route routeFromGPXFile(const std::string & path)
+  {
+      NMEA::Route ret;
+      appendRouteFromGPXFile(path, ret);
+      return ret;
+  }
+}
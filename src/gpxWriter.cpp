@@ -0,0 +1,194 @@
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "formatPosition.h"
+#include "gpxWriter.h"
+
+namespace GPS
+{
+  namespace
+  {
+      // More than the longest shortest-round-trip representation of a double.
+      const std::size_t MAX_NUMBER_LENGTH = 32;
+
+      // More than the longest point element, so that a point never straddles a flush.
+      const std::size_t MAX_POINT_LENGTH = 256;
+
+      // The 'lat' and 'lon' attributes of a point; its elevation is a child element.
+      const PositionFormat COORDINATES { PositionLayout::attributes, PositionFormat::shortest, false };
+  }
+
+  GPXWriter::GPXWriter(std::ostream & out, std::string_view creator)
+      : out(out), buffer(bufferSize), used(0), state(State::document)
+  {
+      append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<gpx version=\"1.1\" creator=\"");
+      appendEscaped(creator);
+      append("\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n");
+  }
+
+  void GPXWriter::beginRoute(std::string_view name)
+  {
+      beginElement(State::document, State::route, "  <rte>\n", name);
+  }
+
+  void GPXWriter::endRoute()
+  {
+      endElement(State::route, State::document, "  </rte>\n");
+  }
+
+  void GPXWriter::beginTrack(std::string_view name)
+  {
+      beginElement(State::document, State::track, "  <trk>\n", name);
+  }
+
+  void GPXWriter::beginTrackSegment()
+  {
+      expectState(State::track, "begin a track segment");
+      append("    <trkseg>\n");
+      state = State::trackSegment;
+  }
+
+  void GPXWriter::endTrackSegment()
+  {
+      endElement(State::trackSegment, State::track, "    </trkseg>\n");
+  }
+
+  void GPXWriter::endTrack()
+  {
+      endElement(State::track, State::document, "  </trk>\n");
+  }
+
+  void GPXWriter::addPoint(const Position & pos)
+  {
+      if (state != State::route && state != State::trackSegment)
+          throw std::logic_error("Cannot add a GPX point outside a route or track segment.");
+
+      reserve(MAX_POINT_LENGTH);
+      append(state == State::route ? "    <rtept " : "      <trkpt ");
+      char * const first = buffer.data() + used;
+      used = formatPosition(first, buffer.data() + buffer.size(), pos, COORDINATES).ptr - buffer.data();
+      append("><ele>");
+      appendNumber(pos.elevation());
+      append(state == State::route ? "</ele></rtept>\n" : "</ele></trkpt>\n");
+  }
+
+  void GPXWriter::writeRoute(const NMEA::Route & route, std::string_view name)
+  {
+      beginRoute(name);
+      for (const Position & pos : route)
+          addPoint(pos);
+      endRoute();
+  }
+
+  void GPXWriter::writeTrack(const NMEA::Route & route, std::string_view name)
+  {
+      beginTrack(name);
+      beginTrackSegment();
+      for (const Position & pos : route)
+          addPoint(pos);
+      endTrackSegment();
+      endTrack();
+  }
+
+  void GPXWriter::finish()
+  {
+      endElement(State::document, State::finished, "</gpx>\n");
+      flush();
+      if (!out.flush())
+          throw std::runtime_error("Cannot write GPX document.");
+  }
+
+  void GPXWriter::expectState(State required, const char * operation) const
+  {
+      if (state != required)
+          throw std::logic_error(std::string("Cannot ") + operation + " here in a GPX document.");
+  }
+
+  void GPXWriter::beginElement(State required, State next, std::string_view openTag, std::string_view name)
+  {
+      expectState(required, "begin a route or track");
+      append(openTag);
+      if (!name.empty())
+      {
+          append("    <name>");
+          appendEscaped(name);
+          append("</name>\n");
+      }
+      state = next;
+  }
+
+  void GPXWriter::endElement(State required, State next, std::string_view closeTag)
+  {
+      expectState(required, "end an element");
+      append(closeTag);
+      state = next;
+  }
+
+  void GPXWriter::append(std::string_view text)
+  {
+      while (used + text.size() > buffer.size())
+      {
+          const std::size_t part = buffer.size() - used;
+          std::memcpy(buffer.data() + used, text.data(), part);
+          used += part;
+          text.remove_prefix(part);
+          flush();
+      }
+      std::memcpy(buffer.data() + used, text.data(), text.size());
+      used += text.size();
+  }
+
+  void GPXWriter::appendEscaped(std::string_view text)
+  {
+      for (std::size_t special = text.find_first_of("&<>\""); special != std::string_view::npos;
+           special = text.find_first_of("&<>\""))
+      {
+          append(text.substr(0, special));
+          switch (text[special])
+          {
+              case '&': append("&amp;"); break;
+              case '<': append("&lt;"); break;
+              case '>': append("&gt;"); break;
+              default:  append("&quot;"); break;
+          }
+          text.remove_prefix(special + 1);
+      }
+      append(text);
+  }
+
+  void GPXWriter::appendNumber(double value)
+  {
+      reserve(MAX_NUMBER_LENGTH);
+      char * const first = buffer.data() + used;
+      used = std::to_chars(first, first + MAX_NUMBER_LENGTH, value).ptr - buffer.data();
+  }
+
+  void GPXWriter::reserve(std::size_t length)
+  {
+      if (used + length > buffer.size())
+          flush();
+  }
+
+  void GPXWriter::flush()
+  {
+      if (!out.write(buffer.data(), used))
+          throw std::runtime_error("Cannot write GPX document.");
+      used = 0;
+  }
+
+  void writeGPXRoute(std::ostream & out, const NMEA::Route & route, std::string_view name)
+  {
+      GPXWriter writer(out);
+      writer.writeRoute(route, name);
+      writer.finish();
+  }
+
+  void writeGPXTrack(std::ostream & out, const NMEA::Route & route, std::string_view name)
+  {
+      GPXWriter writer(out);
+      writer.writeTrack(route, name);
+      writer.finish();
+  }
+}
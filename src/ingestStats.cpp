@@ -0,0 +1,42 @@
+#include <numeric>
+
+#include "ingestStats.h"
+
+namespace NMEA
+{
+  std::uint64_t IngestStats::lines() const
+  {
+    return std::accumulate(scanStatuses.begin(), scanStatuses.end(), std::uint64_t(0));
+  }
+
+  std::uint64_t IngestStats::rejected() const
+  {
+    return lines() - lines(LineOutcome::accepted);
+  }
+
+  std::uint64_t IngestStats::lines(ScanStatus status) const
+  {
+    return scanStatuses[std::size_t(status)];
+  }
+
+  std::uint64_t IngestStats::lines(LineOutcome outcome) const
+  {
+    return outcomes[std::size_t(outcome)];
+  }
+
+  IngestStats::Clock::duration IngestStats::time(IngestStage stage) const
+  {
+    return stageTimes[std::size_t(stage)];
+  }
+
+  IngestStats & IngestStats::operator+=(const IngestStats & other)
+  {
+    for (std::size_t i = 0; i < SCAN_STATUSES; ++i)
+      scanStatuses[i] += other.scanStatuses[i];
+    for (std::size_t i = 0; i < OUTCOMES; ++i)
+      outcomes[i] += other.outcomes[i];
+    for (std::size_t i = 0; i < STAGES; ++i)
+      stageTimes[i] += other.stageTimes[i];
+    return *this;
+  }
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <numeric>
+#include <thread>
+
+#include "logDirectory.h"
+
+namespace NMEA
+{
+  std::vector<LogFileRoute> routesFromLogDirectory(const std::string & directory, unsigned int threads, std::size_t maxOpenFiles)
+  {
+    namespace fs = std::filesystem;
+
+    std::vector<LogFileRoute> ret;
+    std::vector<std::uintmax_t> sizes;
+    for (const fs::directory_entry & entry : fs::directory_iterator(directory)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".log")
+        ret.push_back({ entry.path().string(), Route() });
+    }
+    std::sort(ret.begin(), ret.end(), [](const LogFileRoute & a, const LogFileRoute & b) { return a.path < b.path; });
+    for (const LogFileRoute & file : ret)
+      sizes.push_back(fs::file_size(file.path));
+
+    // The indices of the files, largest first.
+    std::vector<std::size_t> order(ret.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sizes[a] > sizes[b]; });
+
+    // Each worker has at most one file open, so limiting the workers limits the open files.
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t workerCount = std::min<std::size_t>(threads, ret.size());
+    if (maxOpenFiles > 0)
+      workerCount = std::min(workerCount, maxOpenFiles);
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    const auto work = [&] {
+      for (std::size_t job = next++; job < order.size() && !failed; job = next++) {
+        LogFileRoute & file = ret[order[job]];
+        try {
+          file.route = routeFromLogFile(file.path);
+        }
+        catch (...) {
+          failed = true;
+          throw;
+        }
+      }
+    };
+
+    // Run every worker but one on its own thread, and the last on this thread.
+    std::vector<std::future<void>> workers;
+    for (std::size_t i = 1; i < workerCount; ++i)
+      workers.push_back(std::async(std::launch::async, work));
+    std::exception_ptr error;
+    try {
+      work();
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+    for (std::future<void> & worker : workers) {
+      try {
+        worker.get();
+      }
+      catch (...) {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+    if (error)
+      std::rethrow_exception(error);
+
+    return ret;
+  }
+}
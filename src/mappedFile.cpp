@@ -0,0 +1,91 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mappedFile.h"
+
+namespace GPS
+{
+  MappedFile::MappedFile(const std::string & path)
+      : addr(nullptr), length(0)
+  {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+          throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+
+      struct stat info;
+      if (::fstat(fd, &info) != 0)
+      {
+          const int error = errno;
+          ::close(fd);
+          throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(error));
+      }
+
+      // mmap() rejects zero-length mappings, so an empty file is simply left unmapped.
+      if (info.st_size > 0)
+      {
+          void * mapping = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (mapping == MAP_FAILED)
+          {
+              const int error = errno;
+              ::close(fd);
+              throw std::runtime_error("Cannot map " + path + ": " + std::strerror(error));
+          }
+          ::madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+          addr = static_cast<const char *>(mapping);
+          length = info.st_size;
+      }
+
+      // The mapping remains valid after the descriptor is closed.
+      ::close(fd);
+  }
+
+  MappedFile::MappedFile(MappedFile && other) noexcept
+      : addr(std::exchange(other.addr, nullptr)), length(std::exchange(other.length, 0)) {}
+
+  MappedFile & MappedFile::operator=(MappedFile && other) noexcept
+  {
+      if (this != &other)
+      {
+          release();
+          addr = std::exchange(other.addr, nullptr);
+          length = std::exchange(other.length, 0);
+      }
+      return *this;
+  }
+
+  MappedFile::~MappedFile()
+  {
+      release();
+  }
+
+  const char * MappedFile::data() const
+  {
+      return addr;
+  }
+
+  std::size_t MappedFile::size() const
+  {
+      return length;
+  }
+
+  std::string_view MappedFile::contents() const
+  {
+      return std::string_view(addr, length);
+  }
+
+  void MappedFile::release()
+  {
+      if (addr != nullptr)
+          ::munmap(const_cast<char *>(addr), length);
+      addr = nullptr;
+      length = 0;
+  }
+}
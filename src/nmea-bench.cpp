@@ -0,0 +1,210 @@
+/* Microbenchmarks of the NMEA parsing stages and the route geometry.
+ *
+ * Usage: nmea-bench [scale [minimum-milliseconds]]
+ *
+ * Each stage is timed on each of the bundled logs, and on a synthetic log made of all of
+ * the bundled logs repeated 'scale' times (default 100).  Each measurement is repeated
+ * until it has run for the minimum time (default 200 ms), and the fastest repetition is
+ * reported, as one line per stage and input in fixed columns, so that the output of two
+ * builds can be compared with diff.
+ *
+ * Run from the execs directory, as the log paths are relative to it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "allocationCount.h"
+#include "logs.h"
+#include "parseNMEA.h"
+#include "position.h"
+
+using namespace GPS;
+using namespace NMEA;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Accumulates the results of each stage, so that the compiler cannot discard the work.
+volatile std::size_t sink = 0;
+
+std::chrono::nanoseconds minimumTime(std::chrono::milliseconds(200));
+
+struct Input
+{
+    std::string name;
+    std::string text;
+    std::vector<std::string> lines;
+    std::vector<std::string> wellFormed;   // the lines that are well-formed sentences
+    std::vector<SentenceData> checked;     // the data of those that have valid checksums
+    Route route;
+};
+
+Input makeInput(const std::string & name, const std::string & text)
+{
+    Input input { name, text, {}, {}, {}, {} };
+    std::istringstream lines(text);
+    for (std::string line; std::getline(lines, line); )
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        input.lines.push_back(line);
+        if (isWellFormedSentence(line))
+        {
+            input.wellFormed.push_back(line);
+            if (hasValidChecksum(line)) input.checked.push_back(extractSentenceData(line));
+        }
+    }
+    input.route = routeFromLogBuffer(text);
+    return input;
+}
+
+std::string readFile(const std::string & path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void printHeader()
+{
+    std::cout << std::left << std::setw(30) << "stage" << std::setw(20) << "input"
+              << std::right << std::setw(10) << "items" << std::setw(14) << "ns/item"
+              << std::setw(10) << "MB/s" << std::setw(14) << "allocs/item" << '\n';
+}
+
+/* Times the function, which processes the given number of items (and bytes, if any) on
+ * each call, and prints the fastest repetition.
+ */
+template <typename Function>
+void measure(const std::string & stage, const Input & input, std::size_t items, std::size_t bytes, Function function)
+{
+    if (items == 0) return;
+
+    using Clock = std::chrono::steady_clock;
+    Clock::duration fastest = Clock::duration::max();
+    Clock::duration total = Clock::duration::zero();
+    std::size_t allocations = 0;
+    unsigned int repetitions = 0;
+    do
+    {
+        const std::size_t allocationsBefore = allocationCount;
+        const Clock::time_point start = Clock::now();
+        function();
+        const Clock::duration elapsed = Clock::now() - start;
+        allocations = allocationCount - allocationsBefore;
+        fastest = std::min(fastest, elapsed);
+        total += elapsed;
+        ++repetitions;
+    }
+    while (total < minimumTime || repetitions < 3);
+
+    const double nanoseconds = std::chrono::duration<double, std::nano>(fastest).count();
+    std::cout << std::left << std::setw(30) << stage << std::setw(20) << input.name
+              << std::right << std::setw(10) << items
+              << std::fixed << std::setprecision(1) << std::setw(14) << nanoseconds / items;
+    if (bytes > 0)
+        std::cout << std::setw(10) << bytes * 1e3 / nanoseconds;
+    else
+        std::cout << std::setw(10) << "-";
+    std::cout << std::setprecision(2) << std::setw(14) << double(allocations) / items << '\n';
+}
+
+std::size_t totalSize(const std::vector<std::string> & lines)
+{
+    std::size_t size = 0;
+    for (const std::string & line : lines) size += line.size() + 1;
+    return size;
+}
+
+void benchmark(const Input & input)
+{
+    measure("isWellFormedSentence", input, input.lines.size(), totalSize(input.lines), [&] {
+        for (const std::string & line : input.lines) sink = sink + isWellFormedSentence(line);
+    });
+
+    measure("hasValidChecksum", input, input.wellFormed.size(), totalSize(input.wellFormed), [&] {
+        for (const std::string & line : input.wellFormed) sink = sink + hasValidChecksum(line);
+    });
+
+    measure("extractSentenceData", input, input.wellFormed.size(), totalSize(input.wellFormed), [&] {
+        for (const std::string & line : input.wellFormed) sink = sink + extractSentenceData(line).second.size();
+    });
+
+    measure("positionFromSentenceData", input, input.checked.size(), 0, [&] {
+        for (const SentenceData & data : input.checked)
+        {
+            try
+            {
+                sink = sink + std::size_t(positionFromSentenceData(data).latitude());
+            }
+            catch (const std::invalid_argument &)
+            {
+                sink = sink + 1;
+            }
+        }
+    });
+
+    measure("tryPositionFromSentenceData", input, input.checked.size(), 0, [&] {
+        for (const SentenceData & data : input.checked)
+        {
+            const DecodeResult result = tryPositionFromSentenceData(data);
+            sink = sink + (result ? std::size_t(result.position().latitude()) : 1);
+        }
+    });
+
+    measure("routeFromLog", input, input.lines.size(), input.text.size(), [&] {
+        std::istringstream log(input.text);
+        sink = sink + routeFromLog(log).size();
+    });
+
+    measure("routeFromLogBuffer", input, input.lines.size(), input.text.size(), [&] {
+        sink = sink + routeFromLogBuffer(input.text).size();
+    });
+
+    const std::size_t pairs = input.route.empty() ? 0 : input.route.size() - 1;
+    measure("distanceBetween", input, pairs, 0, [&] {
+        double distance = 0;
+        for (std::size_t i = 0; i < pairs; ++i)
+            distance += Position::distanceBetween(input.route[i], input.route[i + 1]);
+        sink = sink + std::size_t(distance);
+    });
+}
+
+int main(int argc, char * argv[])
+{
+    const unsigned long scale = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    if (argc > 2) minimumTime = std::chrono::milliseconds(std::strtoul(argv[2], nullptr, 10));
+
+    const std::vector<std::string> logNames = { "gll.log", "gga_rmc-1.log", "gga_rmc-2.log" };
+
+    std::vector<Input> inputs;
+    std::string allLogs;
+    for (const std::string & name : logNames)
+    {
+        const std::string text = readFile(LogFiles::NMEALogsDir + name);
+        inputs.push_back(makeInput(name, text));
+        allLogs += text;
+        if (!text.empty() && text.back() != '\n') allLogs += '\n';
+    }
+    if (scale > 0)
+    {
+        std::string scaled;
+        scaled.reserve(allLogs.size() * scale);
+        for (unsigned long i = 0; i < scale; ++i) scaled += allLogs;
+        inputs.push_back(makeInput("all.log x" + std::to_string(scale), scaled));
+    }
+
+    std::cout << "# nmea-bench: fastest of repetitions lasting at least "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(minimumTime).count() << " ms\n";
+    printHeader();
+    for (const Input & input : inputs) benchmark(input);
+}
@@ -0,0 +1,496 @@
+/* A generator of synthetic NMEA logs, for load and soak testing of the parsers.
+ *
+ * Each simulated receiver travels at a constant speed around a closed loop of great-circle
+ * paths between GPS::Earth reference points, and reports a fix at every epoch as a group of
+ * GLL, GGA and/or RMC sentences with correct checksums.  The receivers start at different
+ * points of the loop, and their sentences are interleaved.  A proportion of the sentences
+ * can be corrupted, and the output can be paced in (a multiple of) real time.
+ *
+ * The output depends only on the options, so the same seed reproduces the same log.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "earth.h"
+#include "formatPosition.h"
+#include "geometry.h"
+#include "position.h"
+
+using namespace GPS;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+const char * const USAGE =
+    "Usage: nmea-generator [option value]...\n"
+    "  --epochs N          fixes per receiver (default 3600)\n"
+    "  --bytes N[k|M|G]    stop after at least this much output instead\n"
+    "  --receivers N       interleaved receivers (default 1)\n"
+    "  --formats LIST      comma-separated sentence formats: gll,gga,rmc (default gga,rmc)\n"
+    "  --waypoints LIST    comma-separated loop of reference points (default\n"
+    "                      CliftonCampus,CityCampus); also NorthPole, with --formats rmc\n"
+    "                      only.  The parsers read back only northern latitudes, and only\n"
+    "                      western longitudes from GLL and GGA, so points that would give\n"
+    "                      other hemispheres (e.g. Pontianak) are rejected.\n"
+    "  --speed M           metres per second (default 10)\n"
+    "  --interval S        seconds between fixes (default 1)\n"
+    "  --jitter M          maximum horizontal error in metres (default 2)\n"
+    "  --bad-checksum P    proportion of sentences with a wrong checksum (default 0)\n"
+    "  --truncate P        proportion of truncated sentences (default 0)\n"
+    "  --reserved P        proportion of sentences with a stray '$' or '*' (default 0)\n"
+    "  --pace X            emit fixes at X times real time; 0 for maximum speed (default 0)\n"
+    "  --seed N            random seed (default 1)\n"
+    "  --output FILE       write to a file instead of the standard output\n";
+
+struct Options
+{
+    unsigned long long epochs = 3600;
+    unsigned long long bytes = 0;
+    unsigned int receivers = 1;
+    bool gll = false, gga = true, rmc = true;
+    std::vector<Position> waypoints = { Earth::CliftonCampus, Earth::CityCampus };
+    double speed = 10;
+    double interval = 1;
+    double jitter = 2;
+    double badChecksum = 0;
+    double truncate = 0;
+    double reserved = 0;
+    double pace = 0;
+    std::uint64_t seed = 1;
+    std::string output;
+};
+
+std::vector<std::string> split(const std::string & list)
+{
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    for (std::string item; std::getline(in, item, ','); )
+        items.push_back(item);
+    return items;
+}
+
+double proportion(const std::string & value)
+{
+    const double p = std::stod(value);
+    if (!(p >= 0 && p <= 1)) throw std::invalid_argument("Proportions must be between 0 and 1.");
+    return p;
+}
+
+unsigned long long byteCount(const std::string & value)
+{
+    std::size_t end;
+    unsigned long long count = std::stoull(value, &end);
+    const std::string suffix = value.substr(end);
+    if (suffix == "k") count <<= 10;
+    else if (suffix == "M") count <<= 20;
+    else if (suffix == "G") count <<= 30;
+    else if (!suffix.empty()) throw std::invalid_argument("Unknown size suffix \"" + suffix + "\".");
+    return count;
+}
+
+Options parseOptions(int argc, char * argv[])
+{
+    const std::map<std::string, Position> referencePoints = {
+        { "NorthPole", Earth::NorthPole },
+        { "EquatorialMeridian", Earth::EquatorialMeridian },
+        { "EquatorialAntiMeridian", Earth::EquatorialAntiMeridian },
+        { "CliftonCampus", Earth::CliftonCampus },
+        { "CityCampus", Earth::CityCampus },
+        { "Pontianak", Earth::Pontianak } };
+
+    Options options;
+    for (int i = 1; i < argc; i += 2)
+    {
+        const std::string name = argv[i];
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + name + ".");
+        const std::string value = argv[i + 1];
+
+        if (name == "--epochs") options.epochs = std::stoull(value);
+        else if (name == "--bytes") options.bytes = byteCount(value);
+        else if (name == "--receivers") options.receivers = std::stoul(value);
+        else if (name == "--formats")
+        {
+            options.gll = options.gga = options.rmc = false;
+            for (const std::string & format : split(value))
+            {
+                if (format == "gll") options.gll = true;
+                else if (format == "gga") options.gga = true;
+                else if (format == "rmc") options.rmc = true;
+                else throw std::invalid_argument("Unknown sentence format \"" + format + "\".");
+            }
+        }
+        else if (name == "--waypoints")
+        {
+            options.waypoints.clear();
+            for (const std::string & point : split(value))
+            {
+                const auto found = referencePoints.find(point);
+                if (found == referencePoints.end()) throw std::invalid_argument("Unknown reference point \"" + point + "\".");
+                options.waypoints.push_back(found->second);
+            }
+        }
+        else if (name == "--speed") options.speed = std::stod(value);
+        else if (name == "--interval") options.interval = std::stod(value);
+        else if (name == "--jitter") options.jitter = std::stod(value);
+        else if (name == "--bad-checksum") options.badChecksum = proportion(value);
+        else if (name == "--truncate") options.truncate = proportion(value);
+        else if (name == "--reserved") options.reserved = proportion(value);
+        else if (name == "--pace") options.pace = std::stod(value);
+        else if (name == "--seed") options.seed = std::stoull(value);
+        else if (name == "--output") options.output = value;
+        else throw std::invalid_argument("Unknown option " + name + ".");
+    }
+
+    if (options.receivers == 0 || options.waypoints.empty() || !(options.gll || options.gga || options.rmc))
+        throw std::invalid_argument("At least one receiver, waypoint and sentence format are required.");
+    if (!(options.speed >= 0 && options.interval > 0 && options.jitter >= 0 && options.pace >= 0))
+        throw std::invalid_argument("The speed, interval, jitter and pace must not be negative.");
+
+    // Otherwise most of the log would be rejected by the parsers, rather than load them.
+    for (const Position & waypoint : options.waypoints)
+    {
+        if (!(waypoint.latitude() > 0))
+            throw std::invalid_argument("Waypoints must be in the northern hemisphere, as only northern latitudes are parsed.");
+        if ((options.gll || options.gga) && !(waypoint.longitude() < 0))
+            throw std::invalid_argument("GLL and GGA sentences are only parsed with western longitudes, so their waypoints must be west of the prime meridian.");
+    }
+    return options;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+/* A source of random numbers that is the same on every platform, unlike the standard
+ * distributions.
+ */
+class Random
+{
+  public:
+    explicit Random(std::uint64_t seed) : engine(seed) {}
+
+    // Uniform in [0, 1).
+    double uniform() { return (engine() >> 11) * 0x1.0p-53; }
+
+    // Uniform in [0, n).
+    std::size_t below(std::size_t n) { return std::size_t(uniform() * n); }
+
+    bool chance(double p) { return uniform() < p; }
+
+  private:
+    std::mt19937_64 engine;
+};
+
+// The point a fraction of the way along the great circle from one position to another.
+Position intermediatePoint(const Position & from, const Position & to, double fraction)
+{
+    const radians angle = Position::distanceBetween(from, to) / Earth::meanRadius;
+    if (angle == 0) return from;
+
+    const radians lat1 = degToRad(from.latitude()), lon1 = degToRad(from.longitude());
+    const radians lat2 = degToRad(to.latitude()), lon2 = degToRad(to.longitude());
+    const double a = std::sin((1 - fraction) * angle) / std::sin(angle);
+    const double b = std::sin(fraction * angle) / std::sin(angle);
+    const double x = a * std::cos(lat1) * std::cos(lon1) + b * std::cos(lat2) * std::cos(lon2);
+    const double y = a * std::cos(lat1) * std::sin(lon1) + b * std::cos(lat2) * std::sin(lon2);
+    const double z = a * std::sin(lat1) + b * std::sin(lat2);
+    const metres ele = from.elevation() + fraction * (to.elevation() - from.elevation());
+    return Position(radToDeg(std::atan2(z, std::hypot(x, y))), radToDeg(std::atan2(y, x)), ele);
+}
+
+// The initial bearing of the great circle from one position to another, in [0, 360).
+degrees initialBearing(const Position & from, const Position & to)
+{
+    const radians lat1 = degToRad(from.latitude()), lat2 = degToRad(to.latitude());
+    const radians dLon = degToRad(to.longitude() - from.longitude());
+    const degrees bearing = radToDeg(std::atan2(std::sin(dLon) * std::cos(lat2),
+                                                std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dLon)));
+    return bearing < 0 ? bearing + fullRotation : bearing;
+}
+
+struct Fix
+{
+    Position position;
+    degrees course;
+};
+
+// A closed loop of great-circle legs between waypoints.
+class Loop
+{
+  public:
+    explicit Loop(const std::vector<Position> & waypoints)
+    {
+        for (std::size_t i = 0; i < waypoints.size(); ++i)
+        {
+            const Position & from = waypoints[i];
+            const Position & to = waypoints[(i + 1) % waypoints.size()];
+            legs.push_back({ from, to, Position::distanceBetween(from, to) });
+            totalLength += legs.back().length;
+        }
+    }
+
+    metres length() const { return totalLength; }
+
+    Fix at(metres travelled) const
+    {
+        if (totalLength == 0) return { legs.front().from, 0 };
+        travelled = std::fmod(travelled, totalLength);
+        for (const Leg & leg : legs)
+        {
+            if (travelled < leg.length)
+            {
+                const Position pos = intermediatePoint(leg.from, leg.to, travelled / leg.length);
+                return { pos, initialBearing(pos, leg.to) };
+            }
+            travelled -= leg.length;
+        }
+        return { legs.front().from, initialBearing(legs.front().from, legs.front().to) };
+    }
+
+  private:
+    struct Leg
+    {
+        Position from, to;
+        metres length;
+    };
+
+    std::vector<Leg> legs;
+    metres totalLength = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void appendPadded(std::string & out, unsigned long long value, int width)
+{
+    char digits[24];
+    std::snprintf(digits, sizeof(digits), "%0*llu", width, value);
+    out += digits;
+}
+
+// "hhmmss" followed by the given number of decimal places.
+void appendTime(std::string & out, double secondsOfDay, int decimals)
+{
+    const unsigned long long milliseconds = std::llround(std::fmod(secondsOfDay, 86400) * 1000) % 86400000;
+    appendPadded(out, milliseconds / 3600000, 2);
+    appendPadded(out, milliseconds / 60000 % 60, 2);
+    appendPadded(out, milliseconds / 1000 % 60, 2);
+    if (decimals > 0)
+    {
+        out += '.';
+        appendPadded(out, milliseconds % 1000, 3);
+        out.resize(out.size() - (3 - decimals));
+    }
+}
+
+// "ddmmyy" for the given number of days after 2018-02-12.
+void appendDate(std::string & out, long long day)
+{
+    // See: http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    const long long z = day + 17574 + 719468;
+    const long long era = z / 146097;
+    const long long dayOfEra = z - era * 146097;
+    const long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const long long mp = (5 * dayOfYear + 2) / 153;
+    const long long d = dayOfYear - (153 * mp + 2) / 5 + 1;
+    const long long m = mp < 10 ? mp + 3 : mp - 9;
+    const long long y = yearOfEra + era * 400 + (m <= 2);
+    appendPadded(out, d, 2);
+    appendPadded(out, m, 2);
+    appendPadded(out, y % 100, 2);
+}
+
+void appendDDM(std::string & out, const Position & pos)
+{
+    char buffer[maxFormattedPositionLength];
+    const PositionFormat ddm { PositionLayout::ddm, 4, false };
+    out.append(buffer, formatPosition(buffer, buffer + sizeof(buffer), pos, ddm).ptr);
+}
+
+void appendNumber(std::string & out, double value, int decimals)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    out += buffer;
+}
+
+// Appends the '*', the checksum of the sentence that starts at 'start', and a newline.
+void finishSentence(std::string & out, std::size_t start)
+{
+    unsigned char checksum = 0;
+    for (std::size_t i = start + 1; i < out.size(); ++i)
+        checksum ^= static_cast<unsigned char>(out[i]);
+    char digits[4];
+    std::snprintf(digits, sizeof(digits), "*%02X", checksum);
+    out += digits;
+    out += '\n';
+}
+
+class Generator
+{
+  public:
+    explicit Generator(const Options & options)
+        : options(options), loop(options.waypoints), random(options.seed) {}
+
+    // Appends the sentences of every receiver for an epoch.
+    void appendEpoch(std::string & out, unsigned long long epoch)
+    {
+        const double time = epoch * options.interval;
+        for (unsigned int receiver = 0; receiver < options.receivers; ++receiver)
+        {
+            const metres start = loop.length() * receiver / options.receivers;
+            Fix fix = loop.at(start + options.speed * time);
+            fix.position = jittered(fix.position);
+
+            if (options.gll) appendSentence(out, [&] { appendGLL(out, fix, time); });
+            if (options.gga) appendSentence(out, [&] { appendGGA(out, fix, time); });
+            if (options.rmc) appendSentence(out, [&] { appendRMC(out, fix, time); });
+        }
+    }
+
+  private:
+    Position jittered(const Position & pos)
+    {
+        const metres north = (2 * random.uniform() - 1) * options.jitter;
+        const metres east = (2 * random.uniform() - 1) * options.jitter;
+        const degrees lat = std::fmax(-poleLatitude, std::fmin(poleLatitude, pos.latitude() + Earth::latitudeSubtendedBy(north)));
+        const degrees lon = normaliseDeg(pos.longitude() + Earth::longitudeSubtendedBy(east, pos.latitude()));
+        return Position(lat, lon, pos.elevation() + (2 * random.uniform() - 1) * options.jitter);
+    }
+
+    // Appends a sentence with its checksum, then corrupts it as requested.
+    template <typename AppendFields>
+    void appendSentence(std::string & out, AppendFields appendFields)
+    {
+        const std::size_t start = out.size();
+        appendFields();
+        finishSentence(out, start);
+
+        if (random.chance(options.badChecksum))
+        {
+            char & digit = out[out.size() - 2];
+            digit = digit == '0' ? '1' : '0';
+        }
+        if (random.chance(options.reserved))
+        {
+            const std::size_t position = start + 1 + random.below(out.size() - start - 5);
+            out[position] = random.chance(0.5) ? '$' : '*';
+        }
+        if (random.chance(options.truncate))
+        {
+            out.resize(start + 1 + random.below(out.size() - start - 2));
+            out += '\n';
+        }
+    }
+
+    void appendGLL(std::string & out, const Fix & fix, double time)
+    {
+        out += "$GPGLL,";
+        appendDDM(out, fix.position);
+        out += ',';
+        appendTime(out, time, 0);
+    }
+
+    void appendGGA(std::string & out, const Fix & fix, double time)
+    {
+        out += "$GPGGA,";
+        appendTime(out, time, 3);
+        out += ',';
+        appendDDM(out, fix.position);
+        out += ",1,08,,";
+        appendNumber(out, fix.position.elevation(), 1);
+        out += ",M,,M,,";
+    }
+
+    void appendRMC(std::string & out, const Fix & fix, double time)
+    {
+        const double knotsPerMetrePerSecond = 3600.0 / 1852;
+        out += "$GPRMC,";
+        appendTime(out, time, 3);
+        out += ",A,";
+        appendDDM(out, fix.position);
+        out += ',';
+        appendNumber(out, options.speed * knotsPerMetrePerSecond, 3);
+        out += ',';
+        appendNumber(out, fix.course, 2);
+        out += ',';
+        appendDate(out, static_cast<long long>(time / 86400));
+        out += ",,A";
+    }
+
+    const Options & options;
+    const Loop loop;
+    Random random;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void generate(const Options & options, std::ostream & out)
+{
+    const std::size_t BUFFER_SIZE = 1 << 20;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    Generator generator(options);
+    std::string buffer;
+    buffer.reserve(BUFFER_SIZE + 4096);
+    unsigned long long written = 0;
+    for (unsigned long long epoch = 0; options.bytes > 0 ? written < options.bytes : epoch < options.epochs; ++epoch)
+    {
+        if (options.pace > 0)
+        {
+            const std::chrono::duration<double> due(epoch * options.interval / options.pace);
+            std::this_thread::sleep_until(startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+        }
+
+        const std::size_t before = buffer.size();
+        generator.appendEpoch(buffer, epoch);
+        written += buffer.size() - before;
+
+        if (buffer.size() >= BUFFER_SIZE || options.pace > 0)
+        {
+            if (!out.write(buffer.data(), buffer.size()) || (options.pace > 0 && !out.flush()))
+                throw std::runtime_error("Cannot write the log.");
+            buffer.clear();
+        }
+    }
+    if (!out.write(buffer.data(), buffer.size()) || !out.flush())
+        throw std::runtime_error("Cannot write the log.");
+}
+
+int main(int argc, char * argv[])
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+        if (options.output.empty())
+        {
+            std::ios::sync_with_stdio(false);
+            generate(options, std::cout);
+        }
+        else
+        {
+            std::ofstream file(options.output, std::ios::binary);
+            if (!file) throw std::runtime_error("Cannot create " + options.output);
+            generate(options, file);
+        }
+    }
+    catch (const std::invalid_argument & e)
+    {
+        std::cerr << e.what() << '\n' << USAGE;
+        return 1;
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
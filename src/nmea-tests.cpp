@@ -2,8 +2,13 @@
 #define BOOST_TEST_MODULE ParseNMEATests
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
 #include <string>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 #include <utility>
 #include <ostream>
@@ -11,8 +16,28 @@
 #include <sstream>
 #include <iostream>
 
+#include "allocationCount.h"
+#include "binaryRoute.h"
+#include "compactRoute.h"
+#include "logDirectory.h"
 #include "logs.h"
+#include "parseDecimal.h"
 #include "parseNMEA.h"
+#include "pipelineNMEA.h"
+#include "routeColumns.h"
+#include "routeDistance.h"
+#include "earth.h"
+#include "epochFusion.h"
+#include "formatPosition.h"
+#include "gpxReader.h"
+#include "gpxWriter.h"
+#include "ingestStats.h"
+#include "scanKernels.h"
+#include "sentenceFormats.h"
+#include "simplifyRoute.h"
+#include "spatialIndex.h"
+#include "spscRing.h"
+#include "streamNMEA.h"
 
 using namespace GPS;
 using namespace NMEA;
@@ -135,6 +160,90 @@ BOOST_AUTO_TEST_SUITE_END()
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_SUITE( ScanSentence )
+
+BOOST_AUTO_TEST_CASE( ScanValidSentence )
+{
+    SentenceView view;
+    BOOST_REQUIRE( scanSentence("$GPGLL,5425.31,N,107.03,W,82610*69", view) == ScanStatus::ok );
+    BOOST_CHECK_EQUAL( view.format , "GLL" );
+    BOOST_REQUIRE_EQUAL( view.fieldCount , 5 );
+    BOOST_CHECK_EQUAL( view.field(0) , "5425.31" );
+    BOOST_CHECK_EQUAL( view.field(1) , "N" );
+    BOOST_CHECK_EQUAL( view.field(4) , "82610" );
+}
+
+BOOST_AUTO_TEST_CASE( ScanEmptyFields )
+{
+    SentenceView view;
+    BOOST_REQUIRE( isWellFormed(scanSentence("$GPXXX,,*99", view)) );
+    BOOST_REQUIRE_EQUAL( view.fieldCount , 2 );
+    BOOST_CHECK( view.field(0).empty() );
+    BOOST_CHECK( view.field(1).empty() );
+
+    BOOST_REQUIRE( isWellFormed(scanSentence("$GPXXX*01", view)) );
+    BOOST_CHECK_EQUAL( view.fieldCount , 0 );
+}
+
+BOOST_AUTO_TEST_CASE( ScanRejectionReasons )
+{
+    SentenceView view;
+    BOOST_CHECK( scanSentence("$GPXX*01", view) == ScanStatus::tooShort );
+    BOOST_CHECK( scanSentence("$HPXXX*01", view) == ScanStatus::missingPrefix );
+    BOOST_CHECK( scanSentence("$GPX%X*01", view) == ScanStatus::invalidFormat );
+    BOOST_CHECK( scanSentence("$GPXXX,177", view) == ScanStatus::missingChecksum );
+    BOOST_CHECK( scanSentence("$GPXXX*3g", view) == ScanStatus::invalidChecksum );
+    BOOST_CHECK( scanSentence("$GPXXX,2*3,1*77", view) == ScanStatus::reservedCharacter );
+    BOOST_CHECK( scanSentence("$GPAAA*55", view) == ScanStatus::checksumMismatch );
+}
+
+BOOST_AUTO_TEST_CASE( ScanChecksumBelowSixteen )
+{
+    SentenceView view;
+    BOOST_CHECK( scanSentence("$GPAAA,p*0A", view) == ScanStatus::ok );
+}
+
+BOOST_AUTO_TEST_CASE( ScanKernelsAgree )
+{
+    // Delimiters at every alignment, in buffers longer and shorter than a vector register.
+    std::string bytes;
+    for (int i = 0; i < 150; ++i) bytes += ",x*yz$"[(i * 7 + i / 5) % 6];
+
+    const ScanKernel original = selectedScanKernel();
+    selectScanKernel(ScanKernel::scalar);
+    std::vector<std::vector<std::uint32_t>> expected;
+    std::vector<std::uint8_t> expectedXor;
+    for (std::size_t length = 0; length <= bytes.size(); ++length)
+    {
+        std::vector<std::uint32_t> offsets(length);
+        offsets.resize(findDelimiters(bytes.data(), length, offsets.data(), offsets.size()));
+        expected.push_back(offsets);
+        expectedXor.push_back(xorReduce(bytes.data(), length));
+    }
+
+    for (ScanKernel kernel : {ScanKernel::sse2, ScanKernel::avx2})
+    {
+        if (! isScanKernelSupported(kernel)) continue;
+        selectScanKernel(kernel);
+        for (std::size_t length = 0; length <= bytes.size(); ++length)
+        {
+            std::vector<std::uint32_t> offsets(length);
+            offsets.resize(findDelimiters(bytes.data(), length, offsets.data(), offsets.size()));
+            BOOST_CHECK( offsets == expected[length] );
+            BOOST_CHECK_EQUAL( int(xorReduce(bytes.data(), length)) , int(expectedXor[length]) );
+
+            // A short output buffer still reports the full count.
+            std::uint32_t first[3];
+            BOOST_CHECK_EQUAL( findDelimiters(bytes.data(), length, first, 3) , expected[length].size() );
+        }
+    }
+    selectScanKernel(original);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE( HasValidChecksum )
 
 BOOST_AUTO_TEST_CASE( ValidChecksumMinimalSentence )
@@ -181,6 +290,34 @@ BOOST_AUTO_TEST_CASE( IncorrectChecksumWithLowercaseHexDigit )
     BOOST_CHECK( ! hasValidChecksum("$GPAAE*5f") );
 }
 
+BOOST_AUTO_TEST_CASE( ChecksumBelowSixteen )
+{
+    BOOST_CHECK( hasValidChecksum("$GPAAA,p*0A") );
+    BOOST_CHECK( hasValidChecksum("$GPAAA,p*0a") );
+    BOOST_CHECK( ! hasValidChecksum("$GPAAA,p*A0") );
+}
+
+BOOST_AUTO_TEST_CASE( ChecksumsOnEveryScanKernel )
+{
+    const ScanKernel original = selectedScanKernel();
+    for (ScanKernel kernel : {ScanKernel::scalar, ScanKernel::sse2, ScanKernel::avx2})
+    {
+        if (! isScanKernelSupported(kernel)) continue;
+        selectScanKernel(kernel);
+
+        BOOST_CHECK( hasValidChecksum("$GPAAA*56") );
+        BOOST_CHECK( ! hasValidChecksum("$GPAAA*55") );
+        BOOST_CHECK( hasValidChecksum("$GPAAA,p*0A") );
+        BOOST_CHECK( hasValidChecksum("$GPGLL,5425.31,N,107.03,W,82610*69") );
+        BOOST_CHECK( hasValidChecksum("$GPGGA,113922.000,3722.5993,N,00559.2458,W,1,0,,4.0,M,,M,,*40") );
+        BOOST_CHECK( hasValidChecksum("$GPRMC,113922.000,A,3722.5993,N,00559.2458,W,0.000,0.00,150914,,A*62") );
+        BOOST_CHECK( ! hasValidChecksum("$GPGLL,5425.31,N,107.03,W,82610*24") );
+        BOOST_CHECK( ! hasValidChecksum("$GPGGA,113922.000,3722.5993,N,00559.2458,W,1,0,,4.0,M,,M,,*41") );
+        BOOST_CHECK( ! hasValidChecksum("$GPRMC,113922.000,A,3722.5993,N,00559.2458,W,0.000,0.00,150914,,A*97") );
+    }
+    selectScanKernel(original);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -279,6 +416,86 @@ BOOST_AUTO_TEST_CASE( ExtractMSS )
     checkSentenceDataEqual(actualSentenceData , expectedSentenceData);
 }
 
+BOOST_AUTO_TEST_CASE( ExtractManyFields )
+{
+    std::vector<std::string> fields;
+    std::string sentence = "$GPAAA";
+    for (int i = 0; i < 200; ++i)
+    {
+        fields.push_back(std::to_string(i));
+        sentence += "," + fields.back();
+    }
+    sentence += "*00";
+
+    SentenceData actualSentenceData = extractSentenceData(sentence);
+    SentenceData expectedSentenceData = { "AAA" , fields };
+
+    checkSentenceDataEqual(actualSentenceData , expectedSentenceData);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( ParseDecimal )
+
+BOOST_AUTO_TEST_CASE( ExactDecimals )
+{
+    double value = 0;
+    BOOST_REQUIRE( parseDecimal("280.2", value) );
+    BOOST_CHECK_EQUAL( value , 280.2 );
+    BOOST_REQUIRE( parseDecimal("-34.0", value) );
+    BOOST_CHECK_EQUAL( value , -34.0 );
+    BOOST_REQUIRE( parseDecimal("0.1", value) );
+    BOOST_CHECK_EQUAL( value , 0.1 );
+    BOOST_REQUIRE( parseDecimal("52.91249953", value) );
+    BOOST_CHECK_EQUAL( value , 52.91249953 );
+    BOOST_REQUIRE( parseDecimal(".5", value) );
+    BOOST_CHECK_EQUAL( value , 0.5 );
+    BOOST_REQUIRE( parseDecimal("1.5e2", value) );
+    BOOST_CHECK_EQUAL( value , 150.0 );
+}
+
+BOOST_AUTO_TEST_CASE( LongDecimals )
+{
+    double value = 0;
+    BOOST_REQUIRE( parseDecimal("3.14159265358979323846264338", value) );
+    BOOST_CHECK_EQUAL( value , 3.14159265358979323846264338 );
+    BOOST_REQUIRE( parseDecimal("1e300", value) );
+    BOOST_CHECK_EQUAL( value , 1e300 );
+}
+
+BOOST_AUTO_TEST_CASE( TrailingCharactersIgnored )
+{
+    double value = 0;
+    BOOST_REQUIRE( parseDecimal("12.5M", value) );
+    BOOST_CHECK_EQUAL( value , 12.5 );
+    BOOST_REQUIRE( parseDecimal("7e", value) );
+    BOOST_CHECK_EQUAL( value , 7.0 );
+}
+
+BOOST_AUTO_TEST_CASE( NotANumber )
+{
+    double value = 42;
+    BOOST_CHECK( ! parseDecimal("", value) );
+    BOOST_CHECK( ! parseDecimal("-", value) );
+    BOOST_CHECK( ! parseDecimal(".", value) );
+    BOOST_CHECK( ! parseDecimal("zero", value) );
+    BOOST_CHECK_EQUAL( value , 42 );
+}
+
+BOOST_AUTO_TEST_CASE( ExactDDM )
+{
+    degrees value = 0;
+    BOOST_REQUIRE( parseDDM("5425.31", value) );
+    BOOST_CHECK_EQUAL( value , 326531.0 / 6000.0 );
+    BOOST_REQUIRE( parseDDM("00559.2458", value) );
+    BOOST_CHECK_EQUAL( value , 3592458.0 / 600000.0 );
+    BOOST_REQUIRE( parseDDM("-107.03", value) );
+    BOOST_CHECK_EQUAL( value , -6703.0 / 6000.0 );
+    BOOST_CHECK( ! parseDDM("N", value) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -405,6 +622,14 @@ BOOST_AUTO_TEST_CASE( GGA_NegativeElevation )
     BOOST_CHECK_CLOSE( pos.elevation() , -280.2 , percentageAccuracy );
 }
 
+BOOST_AUTO_TEST_CASE( FullPrecisionCoordinates )
+{
+    SentenceData sentenceData = { "RMC", {"115856.000","A","3722.6710","N","00559.3014","W","0.000","0.00","150914","","A"} };
+    Position pos = positionFromSentenceData(sentenceData);
+    BOOST_CHECK_EQUAL( pos.latitude() , 22426710.0 / 600000.0 );
+    BOOST_CHECK_EQUAL( pos.longitude() , -3593014.0 / 600000.0 );
+}
+
 BOOST_AUTO_TEST_CASE( UnsupportedFormat )
 {
     SentenceData sentenceData = { "MSS", {"55","27","318.0","100",""} };
@@ -465,6 +690,34 @@ BOOST_AUTO_TEST_CASE( MissingFieldsGGA )
     BOOST_CHECK_THROW( positionFromSentenceData(missingM) , std::invalid_argument );
 }
 
+BOOST_AUTO_TEST_CASE( TruncatedFieldVector )
+{
+    // Too few fields to reach the coordinates or the elevation, so none may be read.
+    SentenceData truncatedGLL = { "GLL", {"5425.31","N"} };
+    BOOST_CHECK_THROW( positionFromSentenceData(truncatedGLL) , std::invalid_argument );
+
+    SentenceData truncatedRMC = { "RMC", {"115856.000","A","3722.6710"} };
+    BOOST_CHECK_THROW( positionFromSentenceData(truncatedRMC) , std::invalid_argument );
+
+    SentenceData truncatedGGA = { "GGA", {"170834","4124.8963","N","08151.6838","W"} };
+    BOOST_CHECK_THROW( positionFromSentenceData(truncatedGGA) , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( SentenceFormatDescriptors )
+{
+    static_assert( formatCode("GLL") == ('G' << 16 | 'L' << 8 | 'L') );
+    static_assert( Formats::GLL.fieldCount == 5 && !Formats::GLL.hasElevation() );
+    static_assert( Formats::RMC.fieldCount == 11 && !Formats::RMC.hasElevation() );
+    static_assert( Formats::GGA.fieldCount == 14 && Formats::GGA.elevation == 8 );
+
+    BOOST_CHECK( isSupportedFormat("GLL") );
+    BOOST_CHECK( isSupportedFormat("GGA") );
+    BOOST_CHECK( isSupportedFormat("RMC") );
+    BOOST_CHECK( ! isSupportedFormat("MSS") );
+    BOOST_CHECK( ! isSupportedFormat("GL") );
+    BOOST_CHECK( ! isSupportedFormat("GLLL") );
+}
+
 BOOST_AUTO_TEST_CASE( InvalidFieldData )
 {
     SentenceData invalidGLL_N = { "GLL", {"three","N","107.03","W","82610"} };
@@ -477,6 +730,77 @@ BOOST_AUTO_TEST_CASE( InvalidFieldData )
     BOOST_CHECK_THROW( positionFromSentenceData(invalidGGA_M) , std::invalid_argument );
 }
 
+BOOST_AUTO_TEST_CASE( DecodeErrorsWithoutExceptions )
+{
+    const DecodeResult valid = tryPositionFromSentenceData({ "GLL", {"5425.31","N","107.03","W","82610"} });
+    BOOST_REQUIRE( valid );
+    BOOST_CHECK_EQUAL( valid.position().latitude() , positionFromSentenceData({ "GLL", {"5425.31","N","107.03","W","82610"} }).latitude() );
+    BOOST_CHECK( valid.error() == DecodeError::none );
+
+    const std::vector<std::pair<SentenceData, DecodeError>> cases = {
+        { { "MSS", {"55","27","318.0","100",""} }, DecodeError::unsupportedFormat },
+        { { "GLLX", {} }, DecodeError::unsupportedFormat },
+        { { "RMC", {"115856.000","A","3722.6710","N"} }, DecodeError::missingFields },
+        { { "GLL", {"three","N","107.03","W","82610"} }, DecodeError::invalidCoordinate },
+        { { "GGA", {"170834","4124.8963","N","08151.6838","W","1","05","1.5","zero","M","-34.0","M","",""} }, DecodeError::invalidElevation },
+        { { "GLL", {"9130.00","N","107.03","W","82610"} }, DecodeError::latitudeOutOfRange },
+        { { "GLL", {"9130.00","N","18100.00","W","82610"} }, DecodeError::latitudeOutOfRange },
+        { { "GLL", {"5425.31","N","18100.00","E","82610"} }, DecodeError::longitudeOutOfRange } };
+
+    const std::size_t allocationsBefore = allocationCount;
+    for (const auto & [data, error] : cases)
+    {
+        const DecodeResult result = tryPositionFromSentenceData(data);
+        BOOST_CHECK( ! result );
+        BOOST_CHECK( result.error() == error );
+    }
+    const std::size_t allocationsAfter = allocationCount;
+    BOOST_CHECK_EQUAL( allocationsAfter - allocationsBefore , 0 );
+
+    // The throwing function reports the same errors.
+    for (const auto & [data, error] : cases)
+    {
+        try
+        {
+            positionFromSentenceData(data);
+            BOOST_ERROR( "no exception for " + data.first );
+        }
+        catch (const std::invalid_argument & e)
+        {
+            BOOST_CHECK_EQUAL( std::string(e.what()) , describe(error) );
+        }
+    }
+
+    // The same messages as the Position constructor, which reported these errors before.
+    try
+    {
+        Position(90.5, 0);
+        BOOST_ERROR( "no exception for latitude 90.5" );
+    }
+    catch (const std::invalid_argument & e)
+    {
+        BOOST_CHECK_EQUAL( std::string(e.what()) , describe(DecodeError::latitudeOutOfRange) );
+    }
+    try
+    {
+        Position(0, -180.5);
+        BOOST_ERROR( "no exception for longitude -180.5" );
+    }
+    catch (const std::invalid_argument & e)
+    {
+        BOOST_CHECK_EQUAL( std::string(e.what()) , describe(DecodeError::longitudeOutOfRange) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( PositionsOutOfRangeWithoutExceptions )
+{
+    BOOST_REQUIRE( Position::fromDegrees(52.91249953, -1.18402513, 58) );
+    BOOST_CHECK_EQUAL( Position::fromDegrees(52.91249953, -1.18402513, 58)->elevation() , 58 );
+    BOOST_CHECK( Position::fromDegrees(90, 180) );
+    BOOST_CHECK( ! Position::fromDegrees(90.5, 0) );
+    BOOST_CHECK( ! Position::fromDegrees(0, -180.5) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -527,6 +851,17 @@ BOOST_AUTO_TEST_CASE( LogWithTwoValidSentences )
     BOOST_CHECK_CLOSE( route[1].longitude() , rmcPos.longitude() , percentageAccuracy );
 }
 
+BOOST_AUTO_TEST_CASE( LogWithUnconvertibleData )
+{
+    std::stringstream log;
+    log << "$GPGLL,9130.00,N,107.03,W,82610*66" << std::endl;
+    log << validGLLSentence << std::endl;
+    Route route = routeFromLog(log);
+
+    BOOST_REQUIRE_EQUAL( route.size() , 1 );
+    BOOST_CHECK_CLOSE( route[0].latitude() , gllPos.latitude() , percentageAccuracy );
+}
+
 BOOST_AUTO_TEST_CASE( LogWithBlankLines )
 {
     std::stringstream log;
@@ -618,6 +953,32 @@ BOOST_AUTO_TEST_CASE( LogWithInvalidFields )
     BOOST_CHECK_EQUAL( route.size() , 2 );
 }
 
+BOOST_AUTO_TEST_CASE( LogWithUnacceptedFlags )
+{
+    std::stringstream log;
+    log << "$GPGLL,5425.31,S,107.03,W,82610*74" << std::endl; // GLL must be N
+    log << "$GPGLL,5425.31,N,107.03,E,82610*7B" << std::endl; // GLL must be W
+    log << "$GPGLL,5425.31,N,107.03,W,8261a*38" << std::endl; // time must be digits
+    log << "$GPRMC,113922.000,A,3722.5993,S,00559.2458,W,0.000,0.00,150914,,A*7F" << std::endl; // RMC must be N
+    log << "$GPRMC,113922.000,X,3722.5993,N,00559.2458,W,0.000,0.00,150914,,A*7B" << std::endl; // RMC status must be A/V
+    log << "$GPGGA,113922.000,3722.5993,N,00559.2458,E,1,0,,4.0,M,,M,,*52" << std::endl; // GGA must be W
+    Route route = routeFromLog(log);
+
+    BOOST_CHECK_EQUAL( route.size() , 0 );
+}
+
+BOOST_AUTO_TEST_CASE( LogWithAcceptedFlags )
+{
+    std::stringstream log;
+    log << "$GPRMC,113922.000,A,3722.5993,N,00559.2458,E,0.000,0.00,150914,,A*70" << std::endl; // RMC may be E
+    log << "$GPGGA,113922.000,3722.5993,N,00559.2458,W,1,0,,-4.0,M,,M,,*6D" << std::endl; // negative elevation
+    Route route = routeFromLog(log);
+
+    BOOST_REQUIRE_EQUAL( route.size() , 2 );
+    BOOST_CHECK_CLOSE( route[0].longitude() , -rmcPos.longitude() , percentageAccuracy );
+    BOOST_CHECK_CLOSE( route[1].elevation() , -4.0 , percentageAccuracy );
+}
+
 BOOST_AUTO_TEST_CASE( LargeLog_GLL )
 {
     std::fstream log(LogFiles::NMEALogsDir + "gll.log");
@@ -651,6 +1012,1420 @@ BOOST_AUTO_TEST_CASE( LargeLog_GGA_RMC )
     BOOST_CHECK_CLOSE( route[501].longitude() , -ddmTodd("00559.2403") , percentageAccuracy );
 }
 
+BOOST_AUTO_TEST_CASE( BufferWithCRLFLineEndings )
+{
+    const std::string log = "@Sonygps/ver3.0/wgs-84/\r\n\r\n" + validGLLSentence + "\r\n" + validRMCSentence;
+    Route route = routeFromLogBuffer(log);
+
+    BOOST_REQUIRE_EQUAL( route.size() , 2 );
+    BOOST_CHECK_CLOSE( route[0].latitude() , gllPos.latitude() , percentageAccuracy );
+    BOOST_CHECK_CLOSE( route[1].latitude() , rmcPos.latitude() , percentageAccuracy );
+}
+
+BOOST_AUTO_TEST_CASE( LogFileMatchesStream )
+{
+    for (const std::string name : {"gll.log", "gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        std::fstream log(LogFiles::NMEALogsDir + name);
+        Route streamRoute = routeFromLog(log);
+        Route fileRoute = routeFromLogFile(LogFiles::NMEALogsDir + name);
+
+        BOOST_REQUIRE_EQUAL( fileRoute.size() , streamRoute.size() );
+        for (std::size_t i = 0; i < fileRoute.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL( fileRoute[i].latitude() , streamRoute[i].latitude() );
+            BOOST_CHECK_EQUAL( fileRoute[i].longitude() , streamRoute[i].longitude() );
+            BOOST_CHECK_EQUAL( fileRoute[i].elevation() , streamRoute[i].elevation() );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ParallelLogFileMatchesSerial )
+{
+    for (const std::string name : {"gll.log", "gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        Route serialRoute = routeFromLogFile(LogFiles::NMEALogsDir + name);
+
+        for (unsigned int threads : {2u, 3u, 8u, 0u})
+        {
+            Route parallelRoute = routeFromLogFile(LogFiles::NMEALogsDir + name, threads);
+
+            BOOST_REQUIRE_EQUAL( parallelRoute.size() , serialRoute.size() );
+            for (std::size_t i = 0; i < parallelRoute.size(); ++i)
+            {
+                BOOST_REQUIRE_EQUAL( parallelRoute[i].latitude() , serialRoute[i].latitude() );
+                BOOST_REQUIRE_EQUAL( parallelRoute[i].longitude() , serialRoute[i].longitude() );
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( MissingLogFile )
+{
+    BOOST_CHECK_THROW( routeFromLogFile(LogFiles::NMEALogsDir + "missing.log") , std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( StreamParsing )
+
+const std::string validGLLSentence = "$GPGLL,5425.31,N,107.03,W,82610*69";
+
+BOOST_AUTO_TEST_CASE( ChunkedStreamMatchesLog )
+{
+    std::fstream logStream(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    const std::string log((std::istreambuf_iterator<char>(logStream)), std::istreambuf_iterator<char>());
+    const Route expected = routeFromLogBuffer(log);
+
+    for (std::size_t chunkSize : {1, 7, 82, 4096})
+    {
+        Route streamed;
+        StreamParser parser([&streamed](const Position & pos) { streamed.push_back(pos); });
+        for (std::size_t i = 0; i < log.size(); i += chunkSize)
+            parser.feed(std::string_view(log).substr(i, chunkSize));
+        parser.finish();
+
+        BOOST_REQUIRE_EQUAL( streamed.size() , expected.size() );
+        for (std::size_t i = 0; i < streamed.size(); ++i)
+        {
+            BOOST_REQUIRE_EQUAL( streamed[i].latitude() , expected[i].latitude() );
+            BOOST_REQUIRE_EQUAL( streamed[i].longitude() , expected[i].longitude() );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( PositionDeliveredWhenLineCompletes )
+{
+    int count = 0;
+    StreamParser parser([&count](const Position &) { ++count; });
+
+    parser.feed(validGLLSentence.substr(0, 10));
+    BOOST_CHECK_EQUAL( count , 0 );
+    parser.feed(validGLLSentence.substr(10) + "\r");
+    BOOST_CHECK_EQUAL( count , 0 );
+    parser.feed("\n");
+    BOOST_CHECK_EQUAL( count , 1 );
+
+    parser.feed(validGLLSentence);
+    BOOST_CHECK_EQUAL( count , 1 );
+    parser.finish();
+    BOOST_CHECK_EQUAL( count , 2 );
+}
+
+BOOST_AUTO_TEST_CASE( OverlongLinesDiscarded )
+{
+    int count = 0;
+    StreamParser parser([&count](const Position &) { ++count; });
+
+    const std::string overlong(StreamParser::bufferSize + 1, 'x');
+    parser.feed(overlong.substr(0, 100));
+    parser.feed(overlong.substr(100) + "\n" + validGLLSentence + "\n");
+    parser.feed(overlong + "\n");
+
+    BOOST_CHECK_EQUAL( count , 1 );
+    BOOST_CHECK_EQUAL( parser.overlongLines() , 2 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( RouteColumnStorage )
+
+BOOST_AUTO_TEST_CASE( FilledFromLog )
+{
+    std::fstream log(LogFiles::NMEALogsDir + "gga_rmc-1.log");
+    RouteColumns columns;
+    appendRouteFromLog(log, columns);
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-1.log");
+
+    BOOST_REQUIRE_EQUAL( columns.size() , route.size() );
+    BOOST_REQUIRE_EQUAL( columns.latitudes().size() , route.size() );
+    BOOST_REQUIRE_EQUAL( columns.longitudes().size() , route.size() );
+    BOOST_REQUIRE_EQUAL( columns.elevations().size() , route.size() );
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL( columns.latitudes()[i] , route[i].latitude() );
+        BOOST_CHECK_EQUAL( columns.longitudes()[i] , route[i].longitude() );
+        BOOST_CHECK_EQUAL( columns.elevations()[i] , route[i].elevation() );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ConvertsBackToPositions )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gll.log");
+    const RouteColumns columns(route);
+
+    BOOST_CHECK_EQUAL( columns[1000].latitude() , route[1000].latitude() );
+    BOOST_CHECK_EQUAL( columns[1000].longitude() , route[1000].longitude() );
+
+    const Route roundTrip = columns.toRoute();
+    BOOST_REQUIRE_EQUAL( roundTrip.size() , route.size() );
+    BOOST_CHECK_EQUAL( roundTrip.back().latitude() , route.back().latitude() );
+    BOOST_CHECK_EQUAL( std::distance(columns.begin(), columns.end()) , route.size() );
+
+    // Positions are returned by value, so the iterator cannot claim to be a forward iterator.
+    static_assert( std::is_same_v<std::iterator_traits<RouteColumns::const_iterator>::iterator_category,
+                                  std::input_iterator_tag> );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( BatchDistances )
+
+const double percentageAccuracy = 1e-7;
+
+BOOST_AUTO_TEST_CASE( SegmentDistancesMatchDistanceBetween )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    const std::vector<metres> distances = segmentDistances(RouteColumns(route));
+
+    BOOST_REQUIRE_EQUAL( distances.size() , route.size() - 1 );
+    metres total = 0;
+    for (std::size_t i = 0; i + 1 < route.size(); ++i)
+    {
+        const metres expected = Position::distanceBetween(route[i], route[i+1]);
+        if (expected == 0)
+            BOOST_CHECK_SMALL( distances[i] , 1e-9 );
+        else
+            BOOST_CHECK_CLOSE( distances[i] , expected , percentageAccuracy );
+        total += expected;
+    }
+
+    BOOST_CHECK_CLOSE( routeLength(route) , total , percentageAccuracy );
+    BOOST_CHECK_CLOSE( routeLength(RouteColumns(route)) , total , percentageAccuracy );
+    BOOST_CHECK( segmentDistances(route) == distances );
+}
+
+BOOST_AUTO_TEST_CASE( DistancesAcrossTheGlobe )
+{
+    const std::vector<Position> places = { Earth::NorthPole, Earth::EquatorialMeridian, Earth::EquatorialAntiMeridian,
+                                           Earth::CliftonCampus, Earth::CityCampus, Earth::Pontianak,
+                                           Position(-89.9,-179.9), Position(-33.9,151.2), Position(64.1,-21.9) };
+    const RouteColumns columns(places);
+
+    for (const Position & origin : places)
+    {
+        const std::vector<metres> distances = distancesFrom(origin, columns);
+        for (std::size_t i = 0; i < places.size(); ++i)
+        {
+            const metres expected = Position::distanceBetween(origin, places[i]);
+            if (expected < 1)
+                BOOST_CHECK_SMALL( distances[i] , 1e-6 );
+            else
+                BOOST_CHECK_CLOSE( distances[i] , expected , percentageAccuracy );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ShortRoutes )
+{
+    BOOST_CHECK_EQUAL( routeLength(Route()) , 0 );
+    BOOST_CHECK_EQUAL( routeLength(Route{Earth::CityCampus}) , 0 );
+    BOOST_CHECK( segmentDistances(Route{Earth::CityCampus}).empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( ParserContextStorage )
+
+const std::string validGGASentence = "$GPGGA,113922.000,3722.5993,N,00559.2458,W,1,0,,4.0,M,,M,,*40";
+const std::string validRMCSentence = "$GPRMC,113922.000,A,3722.5993,N,00559.2458,W,0.000,0.00,150914,,A*62";
+const std::string validGLLSentence = "$GPGLL,5425.31,N,107.03,W,82610*69";
+
+BOOST_AUTO_TEST_CASE( SteadyStateParsingDoesNotAllocate )
+{
+    ParserContext context;
+    BOOST_REQUIRE( context.parseLine(validGGASentence) ); // grows the storage to fit the longest sentence
+
+    const std::size_t allocationsBefore = allocationCount;
+    std::size_t parsed = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        parsed += context.parseLine(validGGASentence).has_value();
+        parsed += context.parseLine(validRMCSentence).has_value();
+        parsed += context.parseLine(validGLLSentence).has_value();
+    }
+    const std::size_t allocationsAfter = allocationCount;
+
+    BOOST_CHECK_EQUAL( parsed , 3000 );
+    BOOST_CHECK_EQUAL( allocationsAfter - allocationsBefore , 0 );
+}
+
+BOOST_AUTO_TEST_CASE( SteadyStateStreamReadingDoesNotAllocate )
+{
+    std::stringstream log;
+    for (int i = 0; i < 1000; ++i) log << validGGASentence << std::endl;
+
+    ParserContext context;
+    BOOST_REQUIRE( context.readLine(log) );
+    BOOST_REQUIRE( context.parseLine() );
+
+    const std::size_t allocationsBefore = allocationCount;
+    std::size_t parsed = 0;
+    while (context.readLine(log))
+        parsed += context.parseLine().has_value();
+    const std::size_t allocationsAfter = allocationCount;
+
+    BOOST_CHECK_EQUAL( parsed , 999 );
+    BOOST_CHECK_EQUAL( allocationsAfter - allocationsBefore , 0 );
+}
+
+BOOST_AUTO_TEST_CASE( SentenceDataOfLastSentence )
+{
+    ParserContext context;
+    BOOST_REQUIRE( context.parseLine(validRMCSentence) );
+    BOOST_REQUIRE( context.parseLine(validGLLSentence) );
+    BOOST_CHECK( ! context.parseLine("$GPMSS,55,27,318.0,100,*66") );
+
+    const SentenceData expected = { "GLL" , {"5425.31","N","107.03","W","82610"} };
+    BOOST_CHECK( context.sentenceData() == expected );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( EpochFusionTracks )
+
+BOOST_AUTO_TEST_CASE( TimesOfDay )
+{
+    GPS::seconds time = 0;
+    BOOST_CHECK( parseTimeOfDay("094627.000", time) );
+    BOOST_CHECK_EQUAL( time , 9 * 3600 + 46 * 60 + 27 );
+    BOOST_CHECK( parseTimeOfDay("235960", time) );
+    BOOST_CHECK_EQUAL( time , 23 * 3600 + 59 * 60 + 60 );
+    BOOST_CHECK( parseTimeOfDay("82319", time) );
+    BOOST_CHECK_EQUAL( time , 8 * 3600 + 23 * 60 + 19 );
+
+    for (std::string invalid : {"", "2319", "1234567", "240000", "126000", "120061", "094627.", "0946a7", "094627.0a"})
+        BOOST_CHECK_MESSAGE( ! parseTimeOfDay(invalid, time) , invalid );
+    BOOST_CHECK_EQUAL( time , 8 * 3600 + 23 * 60 + 19 );
+}
+
+BOOST_AUTO_TEST_CASE( GGAAndRMCFusedIntoOneFix )
+{
+    const std::string log = "$GPGGA,094627.000,3723.1622,N,00559.5788,W,1,0,,30.0,M,,M,,*7A\n"
+                            "$GPRMC,094627.000,A,3723.1622,N,00559.5788,W,0.000,0.00,150914,,A*6F\n"
+                            "$GPRMC,094642.000,A,3723.1622,N,00559.5717,W,0.000,0.00,150914,,A*6A\n"
+                            "$GPGGA,094642.000,3723.1622,N,00559.5717,W,1,0,,38.0,M,,M,,*77\n";
+    const Track track = trackFromLogBuffer(log);
+
+    BOOST_REQUIRE_EQUAL( track.size() , 2 );
+    BOOST_CHECK_EQUAL( track[0].time , 9 * 3600 + 46 * 60 + 27 );
+    BOOST_CHECK_EQUAL( track[0].position.elevation() , 30.0 );
+    BOOST_CHECK_EQUAL( track[0].position.longitude() , -ddmTodd("00559.5788") );
+    BOOST_CHECK_EQUAL( track[1].time , 9 * 3600 + 46 * 60 + 42 );
+    BOOST_CHECK_EQUAL( track[1].position.elevation() , 38.0 );
+    BOOST_CHECK_EQUAL( track[1].position.longitude() , -ddmTodd("00559.5717") );
+}
+
+BOOST_AUTO_TEST_CASE( DistinctEpochsNotFused )
+{
+    std::stringstream log;
+    log << "$GPGLL,5425.32,N,107.11,W,82319*65" << std::endl
+        << "$GPGLL,5425.32,N,107.1,W,82429*50" << std::endl;
+    const Track track = trackFromLog(log);
+
+    BOOST_REQUIRE_EQUAL( track.size() , 2 );
+    BOOST_CHECK_EQUAL( track[0].time , 8 * 3600 + 23 * 60 + 19 );
+    BOOST_CHECK_EQUAL( track[1].time , 8 * 3600 + 24 * 60 + 29 );
+}
+
+BOOST_AUTO_TEST_CASE( FusedLogHalvesRoute )
+{
+    for (std::string logName : {"gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        std::fstream logStream(LogFiles::NMEALogsDir + logName);
+        const std::string log((std::istreambuf_iterator<char>(logStream)), std::istreambuf_iterator<char>());
+        const Route route = routeFromLogBuffer(log);
+        const Track track = trackFromLogBuffer(log);
+
+        BOOST_CHECK_EQUAL( track.size() * 2 , route.size() );
+        for (std::size_t i = 1; i < track.size(); ++i)
+            BOOST_CHECK_GT( track[i].time , track[i-1].time );
+
+        std::stringstream logLines(log);
+        BOOST_CHECK_EQUAL( trackFromLog(logLines).size() , track.size() );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( RouteSimplification )
+
+// True if every position of a route lies within the tolerance of its simplification.
+bool withinTolerance(const Route & route, const Route & simplified, GPS::metres tolerance)
+{
+    // Search from the segment that was nearest to the previous position.
+    std::size_t hint = 0;
+    for (const Position & pos : route)
+    {
+        bool found = simplified.size() == 1 && Position::distanceBetween(pos, simplified.front()) <= tolerance;
+        for (std::size_t i = 0; i + 1 < simplified.size() && !found; ++i)
+        {
+            const std::size_t segment = (hint + i) % (simplified.size() - 1);
+            if (GPS::distanceFromSegment(pos, simplified[segment], simplified[segment + 1]) <= tolerance)
+            {
+                found = true;
+                hint = segment;
+            }
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+Route simplifyStream(const Route & route, GPS::metres tolerance, std::size_t windowSize)
+{
+    Route kept;
+    StreamSimplifier simplifier(tolerance, [&kept](const Position & pos) { kept.push_back(pos); }, windowSize);
+    for (const Position & pos : route)
+        simplifier.push_back(pos);
+    simplifier.finish();
+    return kept;
+}
+
+BOOST_AUTO_TEST_CASE( DistanceFromSegment )
+{
+    const Position start(0, 0), end(0, 1), beside(0.001, 0.5), beyond(0, 1.5);
+    BOOST_CHECK_CLOSE( GPS::distanceFromSegment(beside, start, end) ,
+                       Position::distanceBetween(beside, Position(0, 0.5)) , 1e-6 );
+    BOOST_CHECK_CLOSE( GPS::distanceFromSegment(beyond, start, end) ,
+                       Position::distanceBetween(beyond, end) , 1e-6 );
+    BOOST_CHECK_EQUAL( GPS::distanceFromSegment(beside, start, start) ,
+                       Position::distanceBetween(beside, start) );
+}
+
+BOOST_AUTO_TEST_CASE( CollinearPositionsRemoved )
+{
+    Route line;
+    for (int i = 0; i <= 100; ++i)
+        line.push_back(Position(52.9, -1.2 + i * 0.0001));
+
+    const Route simplified = simplifyRoute(line, 1);
+    BOOST_REQUIRE_EQUAL( simplified.size() , 2 );
+    BOOST_CHECK_EQUAL( simplified.back().longitude() , line.back().longitude() );
+
+    BOOST_CHECK_EQUAL( simplifyStream(line, 1, 256).size() , 2 );
+    BOOST_CHECK_EQUAL( simplifyStream(line, 1, 10).size() , 11 );
+}
+
+BOOST_AUTO_TEST_CASE( DeviationWithinTolerance )
+{
+    for (std::string logName : {"gll.log", "gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        const Route route = routeFromLogFile(LogFiles::NMEALogsDir + logName);
+        BOOST_CHECK( ! withinTolerance(route, {route.front(), route.back()}, 50) );
+        for (GPS::metres tolerance : {1.0, 10.0, 50.0})
+        {
+            const Route batch = simplifyRoute(route, tolerance);
+            const Route streamed = simplifyStream(route, tolerance, StreamSimplifier::defaultWindowSize);
+
+            BOOST_CHECK_LT( batch.size() , route.size() );
+            BOOST_CHECK_LT( streamed.size() , route.size() );
+            BOOST_CHECK( withinTolerance(route, batch, tolerance) );
+            BOOST_CHECK( withinTolerance(route, streamed, tolerance) );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( StreamingBehindRouteFromLog )
+{
+    std::ifstream log(LogFiles::NMEALogsDir + "gll.log");
+    Route kept;
+    StreamSimplifier simplifier(25, [&kept](const Position & pos) { kept.push_back(pos); });
+    appendRouteFromLog(log, simplifier);
+    simplifier.finish();
+
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gll.log");
+    BOOST_CHECK_LE( kept.size() * 10 , route.size() );
+    BOOST_CHECK_EQUAL( kept.front().latitude() , route.front().latitude() );
+    BOOST_CHECK_EQUAL( kept.back().latitude() , route.back().latitude() );
+    BOOST_CHECK_EQUAL( kept.back().longitude() , route.back().longitude() );
+}
+
+BOOST_AUTO_TEST_CASE( InvalidParameters )
+{
+    BOOST_CHECK_THROW( simplifyRoute(Route(), -1) , std::invalid_argument );
+    BOOST_CHECK_THROW( StreamSimplifier(-1, [](const Position &) {}) , std::invalid_argument );
+    BOOST_CHECK_THROW( StreamSimplifier(1, [](const Position &) {}, 0) , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( SpatialIndexQueries )
+
+// Built on first use, as LogFiles::NMEALogsDir is defined in another translation unit and
+// may not yet be initialised during static initialisation.
+const std::vector<Route> & fleet()
+{
+    static const std::vector<Route> routes = {
+        routeFromLogFile(LogFiles::NMEALogsDir + "gll.log"),
+        routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-1.log"),
+        routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-2.log")
+    };
+    return routes;
+}
+
+// Query positions spread over and around the area covered by the fleet.
+std::vector<Position> queryPositions()
+{
+    std::vector<Position> ret = { Earth::CliftonCampus, Earth::CityCampus, Earth::Pontianak };
+    for (const Route & route : fleet())
+    {
+        for (std::size_t i = 0; i < route.size(); i += 97)
+            ret.push_back(Position(route[i].latitude() + 0.0007, route[i].longitude() - 0.0011));
+    }
+    return ret;
+}
+
+std::vector<SpatialIndex::Match> allPointsByDistance(const Position & pos)
+{
+    const std::vector<Route> & routes = fleet();
+    std::vector<SpatialIndex::Match> ret;
+    for (std::size_t r = 0; r < routes.size(); ++r)
+    {
+        for (std::size_t i = 0; i < routes[r].size(); ++i)
+            ret.push_back({{r, i}, Position::distanceBetween(pos, routes[r][i])});
+    }
+    std::stable_sort(ret.begin(), ret.end(), [](const auto & a, const auto & b) { return a.distance < b.distance; });
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE( NearestPointsMatchLinearScan )
+{
+    const SpatialIndex index(fleet());
+    for (const Position & pos : queryPositions())
+    {
+        const std::vector<SpatialIndex::Match> expected = allPointsByDistance(pos);
+
+        const std::optional<SpatialIndex::Match> nearest = index.nearestPoint(pos);
+        BOOST_REQUIRE( nearest );
+        BOOST_CHECK_EQUAL( nearest->distance , expected.front().distance );
+
+        const std::vector<SpatialIndex::Match> nearest10 = index.nearestPoints(pos, 10);
+        BOOST_REQUIRE_EQUAL( nearest10.size() , 10 );
+        for (std::size_t i = 0; i < nearest10.size(); ++i)
+            BOOST_CHECK_EQUAL( nearest10[i].distance , expected[i].distance );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( PointsWithinRadiusMatchLinearScan )
+{
+    const SpatialIndex index(fleet(), 50);
+    for (const Position & pos : queryPositions())
+    {
+        for (GPS::metres radius : {0.0, 30.0, 250.0, 2000.0})
+        {
+            std::vector<SpatialIndex::Match> expected = allPointsByDistance(pos);
+            expected.erase(std::find_if(expected.begin(), expected.end(), [radius](const auto & m) { return m.distance > radius; }),
+                           expected.end());
+
+            const std::vector<SpatialIndex::Match> within = index.pointsWithin(pos, radius);
+            BOOST_REQUIRE_EQUAL( within.size() , expected.size() );
+            for (std::size_t i = 0; i < within.size(); ++i)
+            {
+                BOOST_CHECK_EQUAL( within[i].distance , expected[i].distance );
+                BOOST_CHECK_EQUAL( Position::distanceBetween(pos, index.position(within[i].entry)) , within[i].distance );
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( SegmentsMatchLinearScan )
+{
+    const SpatialIndex index(fleet());
+    for (const Position & pos : queryPositions())
+    {
+        GPS::metres nearestDistance = std::numeric_limits<GPS::metres>::infinity();
+        std::size_t within100 = 0;
+        for (const Route & route : fleet())
+        {
+            for (std::size_t i = 0; i + 1 < route.size(); ++i)
+            {
+                const GPS::metres distance = GPS::distanceFromSegment(pos, route[i], route[i+1]);
+                nearestDistance = std::min(nearestDistance, distance);
+                within100 += distance <= 100;
+            }
+        }
+
+        const std::optional<SpatialIndex::Match> nearest = index.nearestSegment(pos);
+        BOOST_REQUIRE( nearest );
+        BOOST_CHECK_EQUAL( nearest->distance , nearestDistance );
+        BOOST_CHECK_EQUAL( index.segmentsWithin(pos, 100).size() , within100 );
+    }
+}
+
+// Near or far from the routes, a nearest-neighbour search visits only a few of the entries.
+BOOST_AUTO_TEST_CASE( NearestSearchesVisitFewEntries )
+{
+    const SpatialIndex index(fleet());
+    std::size_t pointCount = 0;
+    for (const Route & route : fleet())
+        pointCount += route.size();
+
+    std::vector<Position> queries = queryPositions();
+    queries.insert(queries.end(), { Position(60, 10), Position(-30, 100), Position(89.5, -120) });
+    for (const Position & pos : queries)
+    {
+        SpatialIndex::QueryStats pointStats, segmentStats;
+        BOOST_REQUIRE( index.nearestPoint(pos, &pointStats) );
+        BOOST_REQUIRE( index.nearestSegment(pos, &segmentStats) );
+        BOOST_CHECK_GT( pointStats.distances , 0 );
+        BOOST_CHECK_LT( pointStats.distances * 10 , pointCount );
+        BOOST_CHECK_LT( segmentStats.distances * 10 , pointCount );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( AcrossTheAntiMeridian )
+{
+    const Route route = { Position(10, 179.9995), Position(10, -179.9995), Position(10, -179.9) };
+    const SpatialIndex index(route);
+
+    const Position east(10, 179.9999);
+    BOOST_CHECK_EQUAL( index.pointsWithin(east, 100).size() , 2 );
+    BOOST_CHECK_EQUAL( index.nearestPoints(east, 3).back().entry.index , 2 );
+    BOOST_REQUIRE( index.nearestSegment(east) );
+    BOOST_CHECK_EQUAL( index.nearestSegment(east)->entry.index , 0 );
+    BOOST_CHECK_LT( index.nearestSegment(east)->distance , 1 );
+}
+
+BOOST_AUTO_TEST_CASE( AcrossThePole )
+{
+    // (80,180) is many columns from (80,0) but nearer over the pole than either other position.
+    const Route route = { Position(59.5, 0), Position(80, 180), Position(56.5, 0) };
+    const SpatialIndex index(route);
+
+    for (const Position & pos : { Position(80, 0), Position(89, 90), Position(85, -45), Position(70, 120) })
+    {
+        std::vector<SpatialIndex::Match> expected;
+        for (std::size_t i = 0; i < route.size(); ++i)
+            expected.push_back({{0, i}, Position::distanceBetween(pos, route[i])});
+        std::sort(expected.begin(), expected.end(), [](const auto & a, const auto & b) { return a.distance < b.distance; });
+
+        const std::optional<SpatialIndex::Match> nearest = index.nearestPoint(pos);
+        BOOST_REQUIRE( nearest );
+        BOOST_CHECK_EQUAL( nearest->entry.index , expected.front().entry.index );
+        BOOST_CHECK_EQUAL( nearest->distance , expected.front().distance );
+
+        const std::vector<SpatialIndex::Match> nearest2 = index.nearestPoints(pos, 2);
+        BOOST_REQUIRE_EQUAL( nearest2.size() , 2 );
+        BOOST_CHECK_EQUAL( nearest2[1].distance , expected[1].distance );
+
+        const GPS::metres nearestSegment = std::min(GPS::distanceFromSegment(pos, route[0], route[1]),
+                                                    GPS::distanceFromSegment(pos, route[1], route[2]));
+        BOOST_REQUIRE( index.nearestSegment(pos) );
+        BOOST_CHECK_EQUAL( index.nearestSegment(pos)->distance , nearestSegment );
+    }
+    BOOST_CHECK_EQUAL( index.nearestPoint(Position(80, 0))->entry.index , 1 );
+}
+
+BOOST_AUTO_TEST_CASE( LongSegment )
+{
+    // A gap in reception from Nottingham to Seville, which crosses tens of thousands of cells
+    // (millions at 1 m), so is held in blocks of cells instead; a query finds its distance once.
+    const Route route = { Position(52.9, -1.18), Position(37.38, -5.99) };
+
+    std::vector<Position> queries = { route[0], route[1], Earth::CliftonCampus, Earth::Pontianak };
+    for (double t : {0.1, 0.25, 0.5, 0.75, 0.9})
+    {
+        const Position along(52.9 + t * (37.38 - 52.9), -1.18 + t * (-5.99 + 1.18));
+        queries.push_back(along);
+        queries.push_back(Position(along.latitude() + 0.004, along.longitude() - 0.003));
+        queries.push_back(Position(along.latitude() - 0.2, along.longitude() + 0.5));
+    }
+    for (GPS::metres cellSize : {SpatialIndex::defaultCellSize, 1.0})
+    {
+        const SpatialIndex index(route, cellSize);
+        for (const Position & pos : queries)
+        {
+            const GPS::metres expected = GPS::distanceFromSegment(pos, route[0], route[1]);
+            SpatialIndex::QueryStats nearestStats, withinStats;
+            const std::optional<SpatialIndex::Match> nearest = index.nearestSegment(pos, &nearestStats);
+            BOOST_REQUIRE( nearest );
+            BOOST_CHECK_EQUAL( nearest->distance , expected );
+            BOOST_CHECK_EQUAL( index.segmentsWithin(pos, 1000, &withinStats).size() , expected <= 1000 ? 1 : 0 );
+            BOOST_CHECK_EQUAL( nearestStats.distances , 1 );
+            BOOST_CHECK_LE( withinStats.distances , 1 );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( EmptyIndex )
+{
+    const Route empty;
+    const SpatialIndex index(empty);
+    BOOST_CHECK( ! index.nearestPoint(Earth::CliftonCampus) );
+    BOOST_CHECK( ! index.nearestSegment(Earth::CliftonCampus) );
+    BOOST_CHECK( index.pointsWithin(Earth::CliftonCampus, 1000).empty() );
+    BOOST_CHECK( index.nearestPoints(Earth::CliftonCampus, 5).empty() );
+
+    BOOST_CHECK_THROW( SpatialIndex(empty, 0) , std::invalid_argument );
+    BOOST_CHECK_THROW( index.pointsWithin(Earth::CliftonCampus, -1) , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( BinaryRoutes )
+
+const std::string binaryRoutePath = "binary-route-test.bin";
+
+void checkIdentical(const Route & actual, const Route & expected)
+{
+    BOOST_REQUIRE_EQUAL( actual.size() , expected.size() );
+    for (std::size_t i = 0; i < actual.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL( actual[i].latitude() , expected[i].latitude() );
+        BOOST_REQUIRE_EQUAL( actual[i].longitude() , expected[i].longitude() );
+        BOOST_REQUIRE_EQUAL( actual[i].elevation() , expected[i].elevation() );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( NMEARoutesRestoredExactly )
+{
+    for (std::string logName : {"gll.log", "gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        const std::string logPath = LogFiles::NMEALogsDir + logName;
+        const Route route = routeFromLogFile(logPath);
+        for (std::size_t blockSize : {1, 7, 4096})
+        {
+            writeBinaryRouteFile(binaryRoutePath, route, blockSize);
+            checkIdentical(routeFromBinaryFile(binaryRoutePath), route);
+        }
+
+        // Much smaller than the log it came from.
+        BOOST_CHECK_LT( GPS::MappedFile(binaryRoutePath).size() * 5 , GPS::MappedFile(logPath).size() );
+    }
+    std::remove(binaryRoutePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( RandomAccess )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    writeBinaryRouteFile(binaryRoutePath, route, 100);
+    const BinaryRouteFile archive(binaryRoutePath);
+
+    BOOST_CHECK_EQUAL( archive.size() , route.size() );
+    BOOST_CHECK_EQUAL( archive.blockCount() , (route.size() + 99) / 100 );
+    for (std::size_t i : {std::size_t(0), std::size_t(99), std::size_t(100), std::size_t(1234), route.size() - 1})
+    {
+        BOOST_CHECK_EQUAL( archive[i].latitude() , route[i].latitude() );
+        BOOST_CHECK_EQUAL( archive[i].longitude() , route[i].longitude() );
+        BOOST_CHECK_EQUAL( archive[i].elevation() , route[i].elevation() );
+    }
+    BOOST_CHECK_THROW( archive[route.size()] , std::out_of_range );
+
+    RouteColumns columns;
+    archive.appendBlock(3, columns);
+    BOOST_REQUIRE_EQUAL( columns.size() , 100 );
+    BOOST_CHECK_EQUAL( columns[0].latitude() , route[300].latitude() );
+    std::remove(binaryRoutePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( ExtremeCoordinates )
+{
+    const Route route = { Position(90, 180, -11034.5), Position(-90, -180, 8848.9), Earth::CliftonCampus, Position(0, 0) };
+    std::stringstream archive;
+    writeBinaryRoute(archive, route);
+    std::ofstream(binaryRoutePath, std::ios::binary) << archive.rdbuf();
+
+    const Route restored = routeFromBinaryFile(binaryRoutePath);
+    BOOST_REQUIRE_EQUAL( restored.size() , 4 );
+    BOOST_CHECK_EQUAL( restored[0].latitude() , 90 );
+    BOOST_CHECK_EQUAL( restored[1].longitude() , -180 );
+    BOOST_CHECK_EQUAL( restored[1].elevation() , 8848.9 );
+    BOOST_CHECK_CLOSE( restored[2].latitude() , Earth::CliftonCampus.latitude() , 1e-6 );
+    BOOST_CHECK_CLOSE( restored[2].elevation() , Earth::CliftonCampus.elevation() , 1e-6 );
+    std::remove(binaryRoutePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( EmptyRoute )
+{
+    writeBinaryRouteFile(binaryRoutePath, Route());
+    const BinaryRouteFile archive(binaryRoutePath);
+    BOOST_CHECK_EQUAL( archive.size() , 0 );
+    BOOST_CHECK_EQUAL( archive.blockCount() , 0 );
+    BOOST_CHECK( archive.toRoute().empty() );
+    std::remove(binaryRoutePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( InvalidArchives )
+{
+    std::stringstream unused;
+    BOOST_CHECK_THROW( writeBinaryRoute(unused, Route(), 0) , std::invalid_argument );
+    BOOST_CHECK_THROW( writeBinaryRoute(unused, Route(), std::size_t(UINT32_MAX) + 1) , std::invalid_argument );
+    BOOST_CHECK( unused.str().empty() );
+    writeBinaryRoute(unused, Route(), UINT32_MAX);
+    BOOST_CHECK( ! unused.str().empty() );
+
+    std::ofstream(binaryRoutePath) << "$GPGLL,5425.31,N,107.03,W,82610*69";
+    BOOST_CHECK_THROW( BinaryRouteFile{binaryRoutePath} , std::runtime_error );
+
+    // Truncate a valid archive so that its index no longer matches.
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gll.log");
+    std::stringstream archive;
+    writeBinaryRoute(archive, route);
+    const std::string bytes = archive.str();
+    std::ofstream(binaryRoutePath, std::ios::binary) << bytes.substr(0, bytes.size() - 5);
+    BOOST_CHECK_THROW( BinaryRouteFile{binaryRoutePath} , std::runtime_error );
+
+    BOOST_CHECK_THROW( BinaryRouteFile{"no-such-archive.bin"} , std::runtime_error );
+    std::remove(binaryRoutePath.c_str());
+}
+
+// Writes an archive of one block, holding the given latitude, longitude and elevation differences.
+void writeCraftedArchive(const std::vector<std::int64_t> & differences)
+{
+    std::string block;
+    for (std::int64_t difference : differences)
+    {
+        std::uint64_t zigzag = (std::uint64_t(difference) << 1) ^ std::uint64_t(difference >> 63);
+        for (; zigzag >= 0x80; zigzag >>= 7) block.push_back(char(zigzag | 0x80));
+        block.push_back(char(zigzag));
+    }
+
+    // Take the header of a genuine archive with the same number of positions.
+    std::stringstream genuine;
+    writeBinaryRoute(genuine, Route(differences.size() / 3, Position(0, 0)));
+    const std::size_t headerSize = 32;
+    std::string bytes = genuine.str().substr(0, headerSize);
+    for (std::size_t i = 0; i < 8; ++i)
+        bytes[headerSize - 8 + i] = char((headerSize + block.size()) >> (8 * i));
+    bytes += block;
+    for (std::size_t i = 0; i < 8; ++i)
+        bytes.push_back(char(headerSize >> (8 * i)));
+    std::ofstream(binaryRoutePath, std::ios::binary) << bytes;
+}
+
+BOOST_AUTO_TEST_CASE( CorruptCoordinates )
+{
+    const std::int64_t degree = std::int64_t(BinaryRoute::unitsPerDegree);
+    const std::int64_t huge = std::numeric_limits<std::int64_t>::max();
+
+    // A latitude beyond the pole, after a valid position.
+    writeCraftedArchive({ 89 * degree, 0, 0, 2 * degree, 0, 0 });
+    {
+        const BinaryRouteFile archive(binaryRoutePath);
+        BOOST_CHECK_EQUAL( archive[0].latitude() , 89 );
+        BOOST_CHECK_THROW( archive[1] , std::runtime_error );
+        BOOST_CHECK_THROW( archive.toRoute() , std::runtime_error );
+    }
+
+    // A longitude beyond the anti-meridian.
+    writeCraftedArchive({ 0, 181 * degree, 0 });
+    BOOST_CHECK_THROW( routeFromBinaryFile(binaryRoutePath) , std::runtime_error );
+
+    // Differences whose sums would overflow.
+    for (const std::vector<std::int64_t> & differences : { std::vector<std::int64_t>{ huge, 0, 0, huge, 0, 0 },
+                                                           std::vector<std::int64_t>{ 0, -huge, 0, 0, -huge, 0 },
+                                                           std::vector<std::int64_t>{ 0, 0, huge, 0, 0, huge } })
+    {
+        writeCraftedArchive(differences);
+        BOOST_CHECK_THROW( routeFromBinaryFile(binaryRoutePath) , std::runtime_error );
+    }
+    std::remove(binaryRoutePath.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( GPXWriting )
+
+BOOST_AUTO_TEST_CASE( RouteDocument )
+{
+    const Route route = { Earth::CliftonCampus, Position(-0.5, 109.322134, -12.25) };
+    std::stringstream gpx;
+    writeGPXRoute(gpx, route, "Clifton & back");
+
+    BOOST_CHECK_EQUAL( gpx.str() ,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<gpx version=\"1.1\" creator=\"NTU-GPS\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+        "  <rte>\n"
+        "    <name>Clifton &amp; back</name>\n"
+        "    <rtept lat=\"52.91249953\" lon=\"-1.18402513\"><ele>58</ele></rtept>\n"
+        "    <rtept lat=\"-0.5\" lon=\"109.322134\"><ele>-12.25</ele></rtept>\n"
+        "  </rte>\n"
+        "</gpx>\n" );
+}
+
+BOOST_AUTO_TEST_CASE( TrackDocument )
+{
+    std::stringstream gpx;
+    GPXWriter writer(gpx);
+    writer.beginTrack();
+    writer.beginTrackSegment();
+    writer.addPoint(Earth::CityCampus);
+    writer.endTrackSegment();
+    writer.beginTrackSegment();
+    writer.endTrackSegment();
+    writer.endTrack();
+    writer.finish();
+
+    const std::string document = gpx.str();
+    BOOST_CHECK( document.find("  <trk>\n    <trkseg>\n      <trkpt lat=\"52.9581383\" lon=\"-1.1542364\"><ele>53</ele></trkpt>\n"
+                               "    </trkseg>\n    <trkseg>\n    </trkseg>\n  </trk>\n</gpx>\n") != std::string::npos );
+    BOOST_CHECK( document.find("<name>") == std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( CoordinatesRoundTrip )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    std::stringstream gpx;
+    writeGPXTrack(gpx, route);
+
+    // Far larger than the writer's buffer, and every number reads back exactly.
+    const std::string document = gpx.str();
+    BOOST_REQUIRE_GT( document.size() , GPXWriter::bufferSize );
+    std::size_t count = 0;
+    for (std::size_t at = document.find("<trkpt lat=\""); at != std::string::npos; at = document.find("<trkpt lat=\"", at + 1))
+    {
+        const char * lat = document.c_str() + at + 12;
+        const char * lon = std::strstr(lat, "lon=\"") + 5;
+        const char * ele = std::strstr(lon, "<ele>") + 5;
+        BOOST_REQUIRE_EQUAL( std::strtod(lat, nullptr) , route[count].latitude() );
+        BOOST_REQUIRE_EQUAL( std::strtod(lon, nullptr) , route[count].longitude() );
+        BOOST_REQUIRE_EQUAL( std::strtod(ele, nullptr) , route[count].elevation() );
+        ++count;
+    }
+    BOOST_CHECK_EQUAL( count , route.size() );
+}
+
+BOOST_AUTO_TEST_CASE( ElementsOutOfOrder )
+{
+    std::stringstream gpx;
+    GPXWriter writer(gpx);
+    BOOST_CHECK_THROW( writer.addPoint(Earth::CityCampus) , std::logic_error );
+    BOOST_CHECK_THROW( writer.endRoute() , std::logic_error );
+    writer.beginTrack();
+    BOOST_CHECK_THROW( writer.addPoint(Earth::CityCampus) , std::logic_error );
+    BOOST_CHECK_THROW( writer.beginRoute() , std::logic_error );
+    BOOST_CHECK_THROW( writer.finish() , std::logic_error );
+    writer.endTrack();
+    writer.finish();
+    BOOST_CHECK_THROW( writer.beginRoute() , std::logic_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( GPXReading )
+
+BOOST_AUTO_TEST_CASE( RoutePointsAndTrackPoints )
+{
+    const std::string gpx =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<gpx version=\"1.1\" creator=\"rtept > trkpt\">\n"
+        "  <wpt lat=\"10\" lon=\"10\"><ele>10</ele></wpt>\n"
+        "  <!-- <rtept lat=\"2\" lon=\"2\"/> -->\n"
+        "  <rte><name><![CDATA[<trkpt lat=\"3\" lon=\"3\">]]></name>\n"
+        "    <rtept lon='-1.18402513' lat = '52.91249953'>\n"
+        "      <time>2018-02-12T10:00:00Z</time>\n"
+        "      <ele> 58.5 </ele>\n"
+        "    </rtept>\n"
+        "    <rtept lat=\"-0.5\" lon=\"109.322134\"/>\n"
+        "  </rte>\n"
+        "  <trk><trkseg><trkpt lat=\"1e-3\" lon=\"180\"><ele>-12</ele></trkpt></trkseg></trk>\n"
+        "</gpx>\n";
+
+    const Route route = routeFromGPXBuffer(gpx);
+    BOOST_REQUIRE_EQUAL( route.size() , 3 );
+    BOOST_CHECK_EQUAL( route[0].latitude() , 52.91249953 );
+    BOOST_CHECK_EQUAL( route[0].longitude() , -1.18402513 );
+    BOOST_CHECK_EQUAL( route[0].elevation() , 58.5 );
+    BOOST_CHECK_EQUAL( route[1].latitude() , -0.5 );
+    BOOST_CHECK_EQUAL( route[1].elevation() , 0 );
+    BOOST_CHECK_EQUAL( route[2].latitude() , 0.001 );
+    BOOST_CHECK_EQUAL( route[2].longitude() , 180 );
+    BOOST_CHECK_EQUAL( route[2].elevation() , -12 );
+}
+
+BOOST_AUTO_TEST_CASE( WrittenTrackReadBack )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-1.log");
+    std::stringstream gpx;
+    writeGPXTrack(gpx, route, "gga_rmc-1");
+
+    RouteColumns columns;
+    appendRouteFromGPXBuffer(gpx.str(), columns);
+    BOOST_REQUIRE_EQUAL( columns.size() , route.size() );
+    for (std::size_t i = 0; i < route.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL( columns[i].latitude() , route[i].latitude() );
+        BOOST_REQUIRE_EQUAL( columns[i].longitude() , route[i].longitude() );
+        BOOST_REQUIRE_EQUAL( columns[i].elevation() , route[i].elevation() );
+    }
+
+    const std::string path = "gpx-read-test.gpx";
+    std::ofstream(path) << gpx.str();
+    BOOST_CHECK_EQUAL( routeFromGPXFile(path).size() , route.size() );
+    std::remove(path.c_str());
+    BOOST_CHECK_THROW( routeFromGPXFile("no-such-file.gpx") , std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( MalformedPoints )
+{
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<rtept lon=\"1\"/>") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<rtept lat=\"1\" lon=\"x\"/>") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<rtept lat=\"1\" lon=\"2") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<rtept lat=1 lon=2/>") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<trkpt lat=\"1\" lon=\"2\"><ele>3</ele>") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<trkpt lat=\"1\" lon=\"2\"><ele>high</ele></trkpt>") , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromGPXBuffer("<trkpt lat=\"91\" lon=\"2\"/>") , std::invalid_argument );
+    BOOST_CHECK( routeFromGPXBuffer("").empty() );
+    BOOST_CHECK( routeFromGPXBuffer("<rteptx lat=\"1\" lon=\"2\"/>").empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( PositionFormatting )
+
+std::string formatted(const Position & pos, const PositionFormat & format = PositionFormat())
+{
+    char buffer[maxFormattedPositionLength];
+    const std::to_chars_result result = formatPosition(buffer, buffer + sizeof(buffer), pos, format);
+    BOOST_REQUIRE( result.ec == std::errc() );
+    return std::string(buffer, result.ptr);
+}
+
+BOOST_AUTO_TEST_CASE( Layouts )
+{
+    const Position pos(52.91249953, -1.18402513, 53.5);
+
+    BOOST_CHECK_EQUAL( formatted(pos) , "lat=\"52.91249953\" lon=\"-1.18402513\" ele=\"53.5\"" );
+    BOOST_CHECK_EQUAL( pos.toString() , formatted(pos) );
+    BOOST_CHECK_EQUAL( pos.toString(false) , "lat=\"52.91249953\" lon=\"-1.18402513\"" );
+
+    BOOST_CHECK_EQUAL( formatted(pos, {PositionLayout::csv}) , "52.91249953,-1.18402513,53.5" );
+    BOOST_CHECK_EQUAL( formatted(pos, {PositionLayout::csv, 3, false}) , "52.912,-1.184" );
+
+    BOOST_CHECK_EQUAL( formatted(pos, {PositionLayout::ddm}) , "5254.7500,N,00111.0415,W,53.5" );
+    BOOST_CHECK_EQUAL( formatted(pos, {PositionLayout::ddm, 2, false}) , "5254.75,N,00111.04,W" );
+    BOOST_CHECK_EQUAL( formatted(pos, {PositionLayout::ddm, 0, false}) , "5255,N,00111,W" );
+}
+
+BOOST_AUTO_TEST_CASE( DDMBearingsAndCarry )
+{
+    BOOST_CHECK_EQUAL( formatted(Position(-0.5, 109.322134), {PositionLayout::ddm, 4, false}) , "0030.0000,S,10919.3280,E" );
+    BOOST_CHECK_EQUAL( formatted(Position(52.999999999, -179.9999999), {PositionLayout::ddm, 4, false}) , "5300.0000,N,18000.0000,W" );
+    BOOST_CHECK_EQUAL( formatted(Position(-0.000000001, 0), {PositionLayout::ddm, 4, false}) , "0000.0000,N,00000.0000,E" );
+}
+
+BOOST_AUTO_TEST_CASE( DDMReadsBack )
+{
+    const Position pos(-33.8688, 151.2093, 58);
+    const std::string text = formatted(pos, {PositionLayout::ddm, PositionFormat::maxPrecision, false});
+    const std::size_t comma1 = text.find(','), comma2 = text.find(',', comma1 + 1), comma3 = text.find(',', comma2 + 1);
+    const Position readBack(text.substr(0, comma1), text[comma1 + 1], text.substr(comma2 + 1, comma3 - comma2 - 1), text[comma3 + 1]);
+    BOOST_CHECK_CLOSE( readBack.latitude() , pos.latitude() , 1e-9 );
+    BOOST_CHECK_CLOSE( readBack.longitude() , pos.longitude() , 1e-9 );
+}
+
+BOOST_AUTO_TEST_CASE( ShortestFormatReadsBackExactly )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    BOOST_REQUIRE( !route.empty() );
+    for (const Position & pos : route)
+    {
+        const std::string text = formatted(pos, {PositionLayout::csv});
+        const std::size_t comma1 = text.find(','), comma2 = text.find(',', comma1 + 1);
+        BOOST_REQUIRE_EQUAL( std::stod(text.substr(0, comma1)) , pos.latitude() );
+        BOOST_REQUIRE_EQUAL( std::stod(text.substr(comma1 + 1, comma2 - comma1 - 1)) , pos.longitude() );
+        BOOST_REQUIRE_EQUAL( std::stod(text.substr(comma2 + 1)) , pos.elevation() );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( DoesNotAllocate )
+{
+    const Route route = routeFromLogFile(LogFiles::NMEALogsDir + "gga_rmc-1.log");
+    char buffer[maxFormattedPositionLength];
+    std::size_t length = 0;
+
+    const std::size_t allocationsBefore = allocationCount;
+    for (PositionLayout layout : {PositionLayout::attributes, PositionLayout::csv, PositionLayout::ddm})
+        for (const Position & pos : route)
+            length += formatPosition(buffer, buffer + sizeof(buffer), pos, {layout}).ptr - buffer;
+    const std::size_t allocationsAfter = allocationCount;
+
+    BOOST_CHECK( length > 0 );
+    BOOST_CHECK_EQUAL( allocationsAfter - allocationsBefore , 0 );
+}
+
+BOOST_AUTO_TEST_CASE( SmallBuffersAndBadPrecisions )
+{
+    const Position pos(52.91249953, -1.18402513, 53.5);
+    char buffer[maxFormattedPositionLength];
+
+    const std::size_t length = formatted(pos, {PositionLayout::csv}).size();
+    BOOST_CHECK( formatPosition(buffer, buffer + length, pos, {PositionLayout::csv}).ec == std::errc() );
+    for (PositionLayout layout : {PositionLayout::attributes, PositionLayout::csv, PositionLayout::ddm})
+    {
+        const std::size_t needed = formatted(pos, {layout}).size();
+        const std::to_chars_result result = formatPosition(buffer, buffer + needed - 1, pos, {layout});
+        BOOST_CHECK( result.ec == std::errc::value_too_large );
+        BOOST_CHECK( result.ptr == buffer + needed - 1 );
+    }
+    BOOST_CHECK( formatPosition(buffer, buffer, pos).ec == std::errc::value_too_large );
+
+    BOOST_CHECK_THROW( formatPosition(buffer, buffer + sizeof(buffer), pos, {PositionLayout::csv, -2}) , std::invalid_argument );
+    BOOST_CHECK_THROW( formatPosition(buffer, buffer + sizeof(buffer), pos, {PositionLayout::csv, PositionFormat::maxPrecision + 1}) , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( IngestStatistics )
+
+// Appends the checksum to a sentence without one.
+std::string withChecksum(const std::string & sentence)
+{
+    unsigned char checksum = 0;
+    for (std::size_t i = 1; i < sentence.size(); ++i) checksum ^= static_cast<unsigned char>(sentence[i]);
+    const char * const HEX = "0123456789ABCDEF";
+    return sentence + '*' + HEX[checksum >> 4] + HEX[checksum & 0xF];
+}
+
+BOOST_AUTO_TEST_CASE( CountsEveryReason )
+{
+    const std::string log =
+        withChecksum("$GPGLL,5425.31,N,107.03,W,82610") + "\n" +
+        withChecksum("$GPGGA,094627.000,3723.1622,N,00559.5788,W,1,0,,30.0,M,,M,,") + "\r\n" +
+        "$GPGLL,5425.31,N,107.03,W,82610*00\n" +
+        "$GP\n" +
+        "GPGLL,5425.31,N,107.03,W,82610*69\n" +
+        "$GPGLL,5425.31,N,107$03,W,82610*69\n" +
+        withChecksum("$GPXYZ,1,2") + "\n" +
+        withChecksum("$GPGSV,1,2") + "\n" +
+        withChecksum("$GPGLL,5425.31,S,107.03,W,82610") + "\n" +
+        "\n";
+
+    IngestStats stats;
+    const Route route = routeFromLogBuffer(log, stats);
+    BOOST_CHECK_EQUAL( route.size() , 2 );
+    BOOST_CHECK_EQUAL( stats.lines() , 10 );
+    BOOST_CHECK_EQUAL( stats.rejected() , 8 );
+    BOOST_CHECK_EQUAL( stats.lines(LineOutcome::accepted) , 2 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::ok) , 5 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::checksumMismatch) , 1 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::tooShort) , 2 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::missingPrefix) , 1 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::reservedCharacter) , 1 );
+    BOOST_CHECK_EQUAL( stats.lines(LineOutcome::unsupportedFormat) , 2 );
+    BOOST_CHECK_EQUAL( stats.lines(LineOutcome::invalidFields) , 1 );
+    BOOST_CHECK_EQUAL( stats.lines(LineOutcome::invalidData) , 0 );
+    BOOST_CHECK( stats.time(IngestStage::scan).count() > 0 );
+    BOOST_CHECK( stats.time(IngestStage::read).count() == 0 );
+
+    // The statistics accumulate over parses.
+    std::istringstream stream(log);
+    BOOST_CHECK_EQUAL( routeFromLog(stream, stats).size() , 2 );
+    BOOST_CHECK_EQUAL( stats.lines() , 20 );
+    BOOST_CHECK_EQUAL( stats.lines(ScanStatus::tooShort) , 4 );
+    BOOST_CHECK( stats.time(IngestStage::read).count() > 0 );
+}
+
+BOOST_AUTO_TEST_CASE( CountsUnconvertibleData )
+{
+    const std::string line = withChecksum("$GPGLL,9999.99,N,107.03,W,82610");
+    IngestStats stats;
+    ParserContext context;
+    BOOST_CHECK( ! context.parseLine(line, stats) );
+    BOOST_CHECK_EQUAL( stats.lines() , 1 );
+    BOOST_CHECK_EQUAL( stats.lines(LineOutcome::invalidData) , 1 );
+    BOOST_CHECK_EQUAL( stats.rejected() , 1 );
+}
+
+BOOST_AUTO_TEST_CASE( ParallelStatisticsMatchSerial )
+{
+    const std::string path = LogFiles::NMEALogsDir + "gga_rmc-2.log";
+    IngestStats serial, parallel;
+    const Route serialRoute = routeFromLogFile(path, serial);
+    const Route parallelRoute = routeFromLogFile(path, parallel, 4);
+
+    BOOST_CHECK_EQUAL( parallelRoute.size() , serialRoute.size() );
+    BOOST_CHECK_EQUAL( serial.lines(LineOutcome::accepted) , serialRoute.size() );
+    BOOST_CHECK_EQUAL( serial.lines() , 1828 );
+    BOOST_CHECK_EQUAL( parallel.lines() , serial.lines() );
+    BOOST_CHECK_EQUAL( parallel.rejected() , serial.rejected() );
+    for (ScanStatus status : {ScanStatus::ok, ScanStatus::tooShort, ScanStatus::missingPrefix, ScanStatus::checksumMismatch})
+        BOOST_CHECK_EQUAL( parallel.lines(status) , serial.lines(status) );
+    for (LineOutcome outcome : {LineOutcome::unsupportedFormat, LineOutcome::invalidFields, LineOutcome::invalidData})
+        BOOST_CHECK_EQUAL( parallel.lines(outcome) , serial.lines(outcome) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( CompactPositions )
+
+BOOST_AUTO_TEST_CASE( ParsedLogsRoundTripExactly )
+{
+    static_assert( sizeof(CompactPosition) * 2 == sizeof(Position) );
+
+    for (const std::string name : {"gll.log", "gga_rmc-1.log", "gga_rmc-2.log"})
+    {
+        const Route route = routeFromLogFile(LogFiles::NMEALogsDir + name);
+        std::fstream log(LogFiles::NMEALogsDir + name);
+        CompactRoute compact;
+        appendRouteFromLog(log, compact);
+
+        BOOST_REQUIRE_EQUAL( compact.size() , route.size() );
+        for (std::size_t i = 0; i < route.size(); ++i)
+        {
+            const Position pos = compact[i];
+            BOOST_REQUIRE_EQUAL( pos.latitude() , route[i].latitude() );
+            BOOST_REQUIRE_EQUAL( pos.longitude() , route[i].longitude() );
+            BOOST_REQUIRE_EQUAL( pos.elevation() , route[i].elevation() );
+            BOOST_REQUIRE( CompactPosition(pos) == compact[i] );
+        }
+        BOOST_CHECK_EQUAL( routeLength(compact) , routeLength(route) );
+        BOOST_CHECK( segmentDistances(compact) == segmentDistances(route) );
+        BOOST_CHECK( distancesFrom(Earth::CityCampus, compact) == distancesFrom(Earth::CityCampus, route) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( FiveDecimalMinutesAreExact )
+{
+    const Position parsed = positionFromSentenceData({ "GGA", {"170834","4124.89637","S","08151.68381","E","1","05","1.5","-280.2","M","-34.0","M","",""} });
+    const Position converted = CompactPosition(parsed);
+    BOOST_CHECK_EQUAL( converted.latitude() , parsed.latitude() );
+    BOOST_CHECK_EQUAL( converted.longitude() , parsed.longitude() );
+    BOOST_CHECK_EQUAL( converted.elevation() , -280.2 );
+}
+
+BOOST_AUTO_TEST_CASE( FinerValuesAreRounded )
+{
+    const CompactPosition compact(Position(52.912499531, -179.999999999, 58.26));
+    BOOST_CHECK_CLOSE( compact.latitude() , 52.912499531 , 1e-7 );
+    BOOST_CHECK_EQUAL( compact.longitude() , -180 );
+    BOOST_CHECK_EQUAL( compact.elevation() , 58.3 );
+    BOOST_CHECK( std::fabs(compact.latitude() - 52.912499531) <= 0.5 / CompactPosition::unitsPerDegree );
+
+    BOOST_CHECK_EQUAL( CompactPosition(Earth::NorthPole).latitude() , 90 );
+    BOOST_CHECK_EQUAL( CompactPosition(Position(-90, 180, -11034)).elevation() , -11034 );
+    BOOST_CHECK_THROW( CompactPosition(Position(0, 0, 3e8)) , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( DistancesMatchPositions )
+{
+    const CompactPosition clifton(Earth::CliftonCampus), city(Earth::CityCampus);
+    BOOST_CHECK_EQUAL( CompactPosition::distanceBetween(clifton, city) , Position::distanceBetween(clifton, city) );
+    BOOST_CHECK_CLOSE( CompactPosition::distanceBetween(clifton, city) ,
+                       Position::distanceBetween(Earth::CliftonCampus, Earth::CityCampus) , 1e-3 );
+
+    CompactRoute route(Route{ Earth::CliftonCampus, Earth::CityCampus });
+    route.push_back(clifton);
+    BOOST_CHECK_EQUAL( route.size() , 3 );
+    BOOST_CHECK_EQUAL( route.toRoute().size() , 3 );
+    BOOST_CHECK_CLOSE( routeLength(route) , 2 * Position::distanceBetween(Earth::CliftonCampus, Earth::CityCampus) , 1e-3 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( LogDirectoryIngest )
+
+BOOST_AUTO_TEST_CASE( OneRoutePerLogFile )
+{
+    const std::vector<std::string> names = { "gga_rmc-1.log", "gga_rmc-2.log", "gll.log" };
+
+    for (unsigned int threads : {1, 2, 0})
+    {
+        for (std::size_t maxOpenFiles : {0, 1, 2})
+        {
+            const std::vector<LogFileRoute> routes = routesFromLogDirectory(LogFiles::NMEALogsDir, threads, maxOpenFiles);
+            BOOST_REQUIRE_EQUAL( routes.size() , names.size() );
+            for (std::size_t i = 0; i < names.size(); ++i)
+            {
+                BOOST_CHECK_EQUAL( std::filesystem::path(routes[i].path).filename().string() , names[i] );
+                const Route expected = routeFromLogFile(LogFiles::NMEALogsDir + names[i]);
+                BOOST_REQUIRE_EQUAL( routes[i].route.size() , expected.size() );
+                for (std::size_t j = 0; j < expected.size(); ++j)
+                    BOOST_REQUIRE_EQUAL( routes[i].route[j].latitude() , expected[j].latitude() );
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( OnlyLogFilesAreParsed )
+{
+    namespace fs = std::filesystem;
+    const fs::path directory = "log-directory-test";
+    fs::remove_all(directory);
+    fs::create_directories(directory / "nested.log");
+    std::ofstream(directory / "a.log") << "$GPGLL,5425.31,N,107.03,W,82610*69\n";
+    std::ofstream(directory / "b.log");
+    std::ofstream(directory / "notes.txt") << "$GPGLL,5425.31,N,107.03,W,82610*69\n";
+
+    const std::vector<LogFileRoute> routes = routesFromLogDirectory(directory.string(), 4, 2);
+    BOOST_REQUIRE_EQUAL( routes.size() , 2 );
+    BOOST_CHECK_EQUAL( routes[0].route.size() , 1 );
+    BOOST_CHECK( routes[1].route.empty() );
+
+    fs::remove_all(directory);
+    BOOST_CHECK_THROW( routesFromLogDirectory(directory.string()) , std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( PipelinedParsing )
+
+BOOST_AUTO_TEST_CASE( RingPreservesOrderAcrossThreads )
+{
+    const int COUNT = 100000;
+    SPSCRing<int> ring(3);
+    std::thread producer([&ring] {
+        for (int i = 0; i < COUNT; ++i) ring.push(i);
+    });
+
+    bool inOrder = true;
+    for (int i = 0; i < COUNT; ++i)
+        inOrder = inOrder && ring.pop() == i;
+    producer.join();
+
+    BOOST_CHECK( inOrder );
+    int value;
+    BOOST_CHECK( ! ring.tryPop(value) );
+    BOOST_CHECK_THROW( SPSCRing<int>(0) , std::invalid_argument );
+}
+
+// A side kept waiting blocks rather than spinning, so it uses (almost) no CPU time.
+BOOST_AUTO_TEST_CASE( WaitingSidesBlock )
+{
+    const auto WAIT = std::chrono::milliseconds(300);
+    const double MAX_CPU_SECONDS = 0.1;
+    SPSCRing<int> ring(1);
+
+    std::clock_t cpuStart = std::clock();
+    std::thread consumer([&ring] { BOOST_CHECK_EQUAL( ring.pop() , 1 ); });
+    std::this_thread::sleep_for(WAIT);
+    ring.push(1);
+    consumer.join();
+    BOOST_CHECK_LT( double(std::clock() - cpuStart) / CLOCKS_PER_SEC , MAX_CPU_SECONDS );
+
+    ring.push(2);
+    cpuStart = std::clock();
+    std::thread producer([&ring] { ring.push(3); });
+    std::this_thread::sleep_for(WAIT);
+    BOOST_CHECK_EQUAL( ring.pop() , 2 );
+    producer.join();
+    BOOST_CHECK_EQUAL( ring.pop() , 3 );
+    BOOST_CHECK_LT( double(std::clock() - cpuStart) / CLOCKS_PER_SEC , MAX_CPU_SECONDS );
+}
+
+BOOST_AUTO_TEST_CASE( MatchesSerialParse )
+{
+    std::fstream logStream(LogFiles::NMEALogsDir + "gga_rmc-2.log");
+    const std::string log((std::istreambuf_iterator<char>(logStream)), std::istreambuf_iterator<char>());
+    const Route expected = routeFromLogBuffer(log);
+
+    for (std::size_t bufferSize : {1, 50, 4096, 1 << 20})
+    {
+        for (unsigned int workers : {1, 3})
+        {
+            for (std::size_t queueDepth : {1, 4})
+            {
+                std::istringstream in(log);
+                const Route route = routeFromLogPipelined(in, { bufferSize, queueDepth, workers });
+                BOOST_REQUIRE_EQUAL( route.size() , expected.size() );
+                for (std::size_t i = 0; i < route.size(); ++i)
+                {
+                    BOOST_REQUIRE_EQUAL( route[i].latitude() , expected[i].latitude() );
+                    BOOST_REQUIRE_EQUAL( route[i].longitude() , expected[i].longitude() );
+                }
+            }
+        }
+    }
+
+    BOOST_CHECK_EQUAL( routeFromLogFilePipelined(LogFiles::NMEALogsDir + "gll.log").size() ,
+                       routeFromLogFile(LogFiles::NMEALogsDir + "gll.log").size() );
+    BOOST_CHECK_THROW( routeFromLogFilePipelined("no-such-file.log") , std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( LinesAtBufferEdges )
+{
+    const std::string sentence = "$GPGLL,5425.31,N,107.03,W,82610*69";
+    for (const std::string & log : {std::string(""), std::string("\n\n"), sentence, sentence + "\r\n" + sentence,
+                                  std::string(5000, 'x') + "\n" + sentence + "\n"})
+    {
+        std::istringstream serialIn(log);
+        const std::size_t expected = routeFromLog(serialIn).size();
+        for (std::size_t bufferSize : {1, 7, 35, 36, 1000})
+        {
+            std::istringstream in(log);
+            BOOST_CHECK_EQUAL( routeFromLogPipelined(in, { bufferSize, 2, 2 }).size() , expected );
+        }
+    }
+
+    std::istringstream in(sentence);
+    BOOST_CHECK_THROW( routeFromLogPipelined(in, { 0, 1, 1 }) , std::invalid_argument );
+    BOOST_CHECK_THROW( routeFromLogPipelined(in, { 1, 0, 1 }) , std::invalid_argument );
+}
+
+// Delivers some text, then fails as a dropped network connection might.
+class FailingStreamBuffer : public std::streambuf
+{
+  public:
+    explicit FailingStreamBuffer(std::string text) : text(std::move(text)) {}
+
+  protected:
+    int_type underflow() override
+    {
+        if (delivered) throw std::runtime_error("network error");
+        delivered = true;
+        setg(text.data(), text.data(), text.data() + text.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+  private:
+    std::string text;
+    bool delivered = false;
+};
+
+BOOST_AUTO_TEST_CASE( StreamErrorsReachTheCaller )
+{
+    std::string log;
+    for (int i = 0; i < 1000; ++i) log += "$GPGLL,5425.31,N,107.03,W,82610*69\n";
+    const auto networkError = [](const std::runtime_error & e) { return std::string(e.what()) == "network error"; };
+
+    FailingStreamBuffer serialBuffer(log);
+    std::istream serialIn(&serialBuffer);
+    serialIn.exceptions(std::ios::badbit);
+    BOOST_CHECK_EXCEPTION( routeFromLog(serialIn) , std::runtime_error , networkError );
+
+    for (std::size_t bufferSize : {7, 4096, 1 << 20})
+    {
+        for (unsigned int workers : {1, 3})
+        {
+            FailingStreamBuffer buffer(log);
+            std::istream in(&buffer);
+            in.exceptions(std::ios::badbit);
+            BOOST_CHECK_EXCEPTION( routeFromLogPipelined(in, { bufferSize, 1, workers }) , std::runtime_error , networkError );
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /////////////////////////////////////////////////////////////////////////////////////////
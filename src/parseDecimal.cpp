@@ -0,0 +1,193 @@
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+
+#include "parseDecimal.h"
+
+namespace GPS
+{
+  namespace
+  {
+    // The largest integer n such that every integer in [0,n] is exactly representable as a double.
+    const std::uint64_t MAX_EXACT_INTEGER = std::uint64_t(1) << 53;
+
+    // Powers of ten that are exactly representable as doubles.
+    const double EXACT_POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const int MAX_EXACT_POWER = 22;
+
+    // Powers of ten that fit in an unsigned 64-bit integer.
+    const std::uint64_t INTEGER_POWERS_OF_TEN[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull
+    };
+
+    // The components of a number at the start of a string.
+    struct NumberText
+    {
+        bool             negative;
+        std::string_view body;     // the number without its sign
+        std::string_view integer;   // digits before the decimal point
+        std::string_view fraction;  // digits after the decimal point
+        bool             hasExponent;
+        int              exponent;
+    };
+
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    std::size_t countDigits(std::string_view str, std::size_t pos)
+    {
+        std::size_t end = pos;
+        while (end < str.size() && isDigit(str[end])) ++end;
+        return end - pos;
+    }
+
+    bool scanNumber(std::string_view str, NumberText & text)
+    {
+        std::size_t pos = 0;
+        text.negative = false;
+        if (pos < str.size() && (str[pos] == '+' || str[pos] == '-'))
+        {
+            text.negative = (str[pos] == '-');
+            ++pos;
+        }
+        const std::size_t start = pos;
+
+        text.integer = str.substr(pos, countDigits(str, pos));
+        pos += text.integer.size();
+
+        text.fraction = std::string_view();
+        if (pos < str.size() && str[pos] == '.')
+        {
+            text.fraction = str.substr(pos + 1, countDigits(str, pos + 1));
+            pos += 1 + text.fraction.size();
+        }
+        if (text.integer.empty() && text.fraction.empty())
+            return false;
+
+        // An exponent is only part of the number if it contains at least one digit.
+        text.hasExponent = false;
+        text.exponent = 0;
+        if (pos < str.size() && (str[pos] == 'e' || str[pos] == 'E'))
+        {
+            std::size_t expPos = pos + 1;
+            if (expPos < str.size() && (str[expPos] == '+' || str[expPos] == '-')) ++expPos;
+            const std::size_t expDigits = countDigits(str, expPos);
+            if (expDigits > 0)
+            {
+                text.hasExponent = true;
+                const char * expStart = str.data() + pos + 1 + (str[pos + 1] == '+');
+                if (std::from_chars(expStart, str.data() + expPos + expDigits, text.exponent).ec != std::errc())
+                    text.exponent = (*expStart == '-') ? -100000 : 100000; // far beyond the range of a double
+                pos = expPos + expDigits;
+            }
+        }
+
+        text.body = str.substr(start, pos - start);
+        return true;
+    }
+
+    // Accumulates digits into 'value', returning false on overflow beyond 19 digits.
+    bool accumulate(std::string_view digits, std::uint64_t & value, std::size_t & significant)
+    {
+        for (char c : digits)
+        {
+            if (value == 0 && c == '0') continue; // leading zeros are not significant
+            if (++significant > 19) return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    // Correctly-rounded conversion of the unsigned part of the number.
+    double toDouble(const NumberText & text)
+    {
+        std::uint64_t mantissa = 0;
+        std::size_t significant = 0;
+        if (accumulate(text.integer, mantissa, significant) && accumulate(text.fraction, mantissa, significant)
+            && mantissa <= MAX_EXACT_INTEGER)
+        {
+            // Both the mantissa and the power of ten are exact, so one operation rounds correctly.
+            const long scale = long(text.fraction.size()) - text.exponent;
+            if (mantissa == 0)
+                return 0.0;
+            if (scale >= 0 && scale <= MAX_EXACT_POWER)
+                return double(mantissa) / EXACT_POWERS_OF_TEN[scale];
+            if (scale < 0 && -scale <= MAX_EXACT_POWER)
+                return double(mantissa) * EXACT_POWERS_OF_TEN[-scale];
+        }
+
+        // Too many digits, or too large an exponent, for the fast path.
+        double value = 0.0;
+        if (std::from_chars(text.body.data(), text.body.data() + text.body.size(), value).ec == std::errc::result_out_of_range)
+        {
+            // Overflow or underflow: decide which from the decimal order of magnitude.
+            const std::size_t intStart = text.integer.find_first_not_of('0');
+            const long order = (intStart != std::string_view::npos)
+                             ? long(text.integer.size() - intStart) + text.exponent
+                             : text.exponent - long(text.fraction.find_first_not_of('0'));
+            value = (order > 0) ? HUGE_VAL : 0.0;
+        }
+        return value;
+    }
+  }
+
+  bool parseDecimal(std::string_view str, double & value)
+  {
+      NumberText text;
+      if (!scanNumber(str, text))
+          return false;
+
+      const double magnitude = toDouble(text);
+      value = text.negative ? -magnitude : magnitude;
+      return true;
+  }
+
+  bool parseDDM(std::string_view str, degrees & value)
+  {
+      NumberText text;
+      if (!scanNumber(str, text))
+          return false;
+
+      std::uint64_t wholeMinutes = 0; // the integer part, as whole minutes
+      std::uint64_t fraction = 0;
+      const std::size_t places = text.fraction.size();
+      std::size_t significant = 0;
+      bool exact = !text.hasExponent && text.integer.size() <= 15 && places <= 14
+                   && accumulate(text.fraction, fraction, significant);
+      if (exact)
+      {
+          std::uint64_t ddm = 0;
+          std::size_t integerDigits = 0;
+          accumulate(text.integer, ddm, integerDigits);
+          wholeMinutes = (ddm / 100) * 60 + ddm % 100;
+
+          // degrees = (wholeMinutes + fraction / 10^places) / 60, as a single exact quotient.
+          exact = wholeMinutes <= (MAX_EXACT_INTEGER - fraction) / INTEGER_POWERS_OF_TEN[places];
+      }
+
+      degrees magnitude;
+      if (exact)
+      {
+          const std::uint64_t numerator = wholeMinutes * INTEGER_POWERS_OF_TEN[places] + fraction;
+          const std::uint64_t denominator = 60 * INTEGER_POWERS_OF_TEN[places];
+          magnitude = double(numerator) / double(denominator);
+      }
+      else
+      {
+          const double ddm = toDouble(text);
+          const double degs = std::floor(ddm / 100);
+          magnitude = degs + (ddm - 100 * degs) / 60.0;
+      }
+
+      value = text.negative ? -magnitude : magnitude;
+      return true;
+  }
+}
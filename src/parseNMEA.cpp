@@ -1,227 +1,415 @@
 #include "parseNMEA.h"
-#include <ctype.h>
-#include <regex>
+#include "geometry.h"
+#include "mappedFile.h"
+#include "parseDecimal.h"
+#include "sentenceFormats.h"
 #include <cmath>
-#include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <future>
+#include <type_traits>
+#include <thread>
 #include <stdexcept>
 
-std::string supported_formats[] = {"GLL", "GGA", "RMC"};
-
 namespace NMEA
 {
-
-  bool isWellFormedSentence(std::string gpsData)
+  namespace
   {
-    const int FIRST_CHARACTER_LENGTH = 1;
-    const int STRING_START = 0;
-    const int PREFIX_LENGTH = 3;
-    const int NMEA_TYPE_LENGTH = 3, NMEA_TYPE_START = 3, NMEA_SECTION_END = gpsData.length() - 3;
-    const int CHECKSUM_LOC1 = gpsData.length() - 2, CHECKSUM_LOC2 = gpsData.length() - 1;
+    using FC = FieldClass;
 
-    // Checks to see if the first 3 characters of the GPS file contain $GP
-    if (gpsData.substr(STRING_START,PREFIX_LENGTH) != "$GP")
-      return false;
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
 
-    // Regex Check For Is Upper case
-    std::string indent = gpsData.substr(NMEA_TYPE_START,NMEA_TYPE_LENGTH);
-    if (!std::regex_match(indent, std::regex("[A-Z]{3,3}")))
-      return false;
+    bool isOneOf(std::string_view field, char a, char b)
+    {
+      return field.length() == 1 && (field[0] == a || field[0] == b);
+    }
 
-    // Check if the third character from the end is an astrix
-    if (gpsData[NMEA_SECTION_END] != '*') 
-      return false;
+    bool isDecimal(std::string_view field)
+    {
+      if (field.empty())
+        return false;
+      return std::count_if(field.begin(), field.end(), [](char c) { return !isDigit(c); }) <= 1;
+    }
 
-    // Check if the last two characters are valid hex values
-    if ((!isxdigit(gpsData[CHECKSUM_LOC1])) || !isxdigit(gpsData[CHECKSUM_LOC2]))
+    bool matchesClass(std::string_view field, FieldClass fieldClass)
+    {
+      switch (fieldClass)
+      {
+        case FC::decimal:       return isDecimal(field);
+        case FC::signedDecimal: return isDecimal(field) || (field.length() > 1 && field[0] == '-' && isDecimal(field.substr(1)));
+        case FC::digits:        return std::all_of(field.begin(), field.end(), isDigit);
+        case FC::empty:         return field.empty();
+        case FC::north:         return field == "N";
+        case FC::west:          return field == "W";
+        case FC::eastWest:      return isOneOf(field, 'E', 'W');
+        case FC::status:        return isOneOf(field, 'A', 'V');
+        case FC::mode:          return isOneOf(field, 'A', 'W');
+        case FC::metres:        return field == "M";
+      }
       return false;
+    }
+
+    template <const SentenceFormat * format>
+    bool fieldsMatch(const SentenceView & view)
+    {
+      if (view.fieldCount != format->fieldCount)
+        return false;
+      for (std::size_t i = 0; i < format->fieldCount; ++i) {
+        if (!matchesClass(view.field(i), format->fieldClasses[i]))
+          return false;
+      }
+      return true;
+    }
 
-    // Sanitize the string and remove valid locations for * and $
-    gpsData.erase(NMEA_SECTION_END);
-    gpsData.erase(STRING_START, FIRST_CHARACTER_LENGTH);
+    std::size_t fieldCount(const SentenceView & view)
+    {
+      return view.fieldCount;
+    }
 
-    // Check to see if the new string contains * and $ and if it does return false
-    if ((gpsData.find('*') != std::string::npos)  || (gpsData.find('$') != std::string::npos))
-      return false;
+    std::size_t fieldCount(const std::vector<std::string> & fields)
+    {
+      return fields.size();
+    }
 
-    // All checks passed
-    return true;
-  }
+    std::string_view fieldAt(const SentenceView & view, std::size_t i)
+    {
+      return view.field(i);
+    }
 
-  bool hasValidChecksum(std::string gpsData)
-  {
-    const int STRING_START = 0;
-    const int FIRST_CHARACTER_LENGTH = 1;
-    const int CHECKSUM_START = gpsData.length() - 2, CHECKSUM_LENGTH = 2;
-    const int POST_CHECKSUM_DATA_START = gpsData.length() - 3, POST_CHECKSUM_DATA_LENGTH = 3;
+    std::string_view fieldAt(const std::vector<std::string> & fields, std::size_t i)
+    {
+      return fields[i];
+    }
+
+    // Decodes the Position from the fields of a sentence of the given format.
+    template <const SentenceFormat * format, typename Fields>
+    DecodeResult decodePosition(const Fields & fields)
+    {
+      // Checks the field count before any field is read
+      if (fieldCount(fields) < format->fieldCount)
+        return DecodeError::missingFields;
+
+      GPS::degrees latitude, longitude;
+      if (!GPS::parseDDM(fieldAt(fields, format->latitude), latitude) ||
+          !GPS::parseDDM(fieldAt(fields, format->longitude), longitude))
+        return DecodeError::invalidCoordinate;
+      GPS::metres elevation = 0;
+      if constexpr (format->hasElevation()) {
+        if (!GPS::parseDecimal(fieldAt(fields, format->elevation), elevation))
+          return DecodeError::invalidElevation;
+      }
 
-    // Get the checksum value from the string
-    std::string checkSum = gpsData.substr(CHECKSUM_START,CHECKSUM_LENGTH);
+      // Checks to see if the NMEA data is West or South and if it is invert it
+      if (fieldAt(fields, format->eastWest) == "W")
+        longitude = -fabs(longitude);
+      if (fieldAt(fields, format->northSouth) == "S")
+        latitude = -fabs(latitude);
 
-    // Remove the checksum value from the string along with the $ from the start
-    gpsData.erase(POST_CHECKSUM_DATA_START, POST_CHECKSUM_DATA_LENGTH);
-    gpsData.erase(STRING_START, FIRST_CHARACTER_LENGTH);
+      if (std::optional<GPS::Position> pos = GPS::Position::fromDegrees(latitude, longitude, elevation))
+        return *pos;
+      return std::abs(latitude) > GPS::poleLatitude ? DecodeError::latitudeOutOfRange : DecodeError::longitudeOutOfRange;
+    }
 
-    // XOR the string to create the checksum
-    int lastNum = 0;
-    for( long unsigned int i = 0; i < gpsData.length(); i++) {
-      lastNum ^= int(gpsData[i]);
+    // Format IDs of any other length cannot be supported (see formatCode()).
+    bool hasFormatCode(std::string_view format)
+    {
+      return format.length() == 3;
     }
+  }
 
-    // Convert generated checksum to hex
-    char generatedCheckSum[20];
-    sprintf(generatedCheckSum, "%X", lastNum);
+  bool isSupportedFormat(std::string_view format)
+  {
+    return hasFormatCode(format) && dispatchFormat(formatCode(format), [](auto) { return true; }, [] { return false; });
+  }
 
-    // Check checksum from string and make it upper case
-    std::for_each(checkSum.begin(), checkSum.end(), [](char & c) {
-        c = ::toupper(c);
-    });
+  bool hasValidFields(const SentenceView & view)
+  {
+    return hasFormatCode(view.format) &&
+           dispatchFormat(formatCode(view.format),
+                          [&](auto format) { return fieldsMatch<format()>(view); },
+                          [] { return false; });
+  }
 
-    // Cross check checksum from file and generated checksum
-    if ((generatedCheckSum !=  checkSum)) 
-      return false;
+  bool isWellFormedSentence(std::string gpsData)
+  {
+    SentenceView view;
+    return isWellFormed(scanSentence(gpsData, view));
+  }
 
-    return true;
+  bool hasValidChecksum(std::string gpsData)
+  {
+    SentenceView view;
+    return scanSentence(gpsData, view) == ScanStatus::ok;
   }
 
-  SentenceData extractSentenceData(std::string sen)
+  SentenceData extractSentenceData(const SentenceView & view)
   {
-    // PREFIX_LENGTH = length of NMEA prefix ($GP)
-    // SUFFIX_LENGTH = length of checksum suffix (*FF)
-    // FORMAT_LENGTH = length of sentance format string (GSV)
-    const int PREFIX_LENGTH = 3, SUFFIX_LENGTH = 3, FORMAT_LENGTH = 3;
-
-    // variables used for operations 
-    std::string formatRet, fieldsStr;
-    formatRet = sen;
-
-    // remove prefix from formatRet & assign it to fieldsStr
-    formatRet.erase(0, PREFIX_LENGTH); 
-    fieldsStr = formatRet;
-
-    // remove everything that is not the format string from formatRet
-    formatRet.erase(FORMAT_LENGTH, std::string::npos); 
-    std::size_t found = fieldsStr.find(',');
-    if(found == std::string::npos){
-      // empty field set
-      SentenceData ret;
-      ret.first = formatRet;
-      ret.second = {};
+    SentenceData ret;
+    ret.first = std::string(view.format);
+    ret.second.reserve(view.fieldCount);
+
+    if (view.allFieldsRecorded()) {
+      for (std::size_t i = 0; i < view.fieldCount; ++i)
+        ret.second.emplace_back(view.field(i));
       return ret;
     }
 
-    //remove the format string and the suffix from fieldsStr
-    fieldsStr.erase(0, FORMAT_LENGTH + 1);
-    fieldsStr.erase(fieldsStr.length() - SUFFIX_LENGTH);
+    // Too many fields for the recorded offsets, so split the remainder by hand.
+    for (std::size_t i = 0; i < SentenceView::maxFields; ++i)
+      ret.second.emplace_back(view.field(i));
+    const std::size_t STAR_LOC = view.sentence.length() - 3;
+    std::size_t start = view.delimiters[SentenceView::maxFields] + 1;
+    while (ret.second.size() < view.fieldCount) {
+      std::size_t end = view.sentence.find(',', start);
+      if (end == std::string_view::npos || end > STAR_LOC)
+        end = STAR_LOC;
+      ret.second.emplace_back(view.sentence.substr(start, end - start));
+      start = end + 1;
+    }
+    return ret;
+  }
+
+  SentenceData extractSentenceData(std::string sen)
+  {
+    SentenceView view;
+    if (!isWellFormed(scanSentence(sen, view)))
+      return SentenceData();
 
-    std::vector<std::string> fieldsRet;
+    return extractSentenceData(view);
+  }
 
-    // iterate fieldsStr to populate fieldsRet
-    std::stringstream s_stream(fieldsStr);
-    while(s_stream.good()) {
-      std::string substr;
-      getline(s_stream, substr, ',');
-      fieldsRet.push_back(substr);
+  const char * describe(DecodeError error)
+  {
+    switch (error)
+    {
+      case DecodeError::none:                return "No error";
+      case DecodeError::unsupportedFormat:   return "Invalid syntax.";
+      case DecodeError::missingFields:       return "Missing Param";
+      case DecodeError::invalidCoordinate:   return "Invalid coordinate";
+      case DecodeError::invalidElevation:    return "Invalid elevation";
+      // As reported by the GPS::Position constructor.
+      case DecodeError::latitudeOutOfRange:  return "Latitude values must not exceed 90.000000 degrees.";
+      case DecodeError::longitudeOutOfRange: return "Longitude values must not exceed 180.000000 degrees.";
     }
+    return "Unknown error";
+  }
 
-    // use formatRet and fieldsRet to init the return value
-    SentenceData ret;
+  DecodeResult tryPositionFromSentenceData(const SentenceData & senData) noexcept
+  {
+    if (!hasFormatCode(senData.first))
+      return DecodeError::unsupportedFormat;
 
+    return dispatchFormat(formatCode(senData.first),
+                          [&](auto format) { return decodePosition<format()>(senData.second); },
+                          []() -> DecodeResult { return DecodeError::unsupportedFormat; });
+  }
 
-    ret.first = formatRet;
-    ret.second = fieldsRet;
-    return ret;
+  GPS::Position positionFromSentenceData(const SentenceData & senData)
+  {
+    const DecodeResult result = tryPositionFromSentenceData(senData);
+    if (!result)
+      throw std::invalid_argument(describe(result.error()));
+    return result.position();
+  }
+
+  bool ParserContext::readLine(std::istream & fs)
+  {
+    return static_cast<bool>(getline(fs, lineBuffer));
+  }
+
+  std::string_view ParserContext::line() const
+  {
+    return lineBuffer;
   }
 
-  float getDegreeConversion(std::string nmeaString) {
-    int DD = std::stof(nmeaString) / 100;
-    return DD + ((std::stof(nmeaString) - DD * 100) / 60);
+  std::optional<GPS::Position> ParserContext::parseLine()
+  {
+    return parseLine(lineBuffer);
   }
 
-  GPS::Position convertPosition (SentenceData senData,long unsigned int size, int NS, int EW,float other = 0) {
-    
-    const std::string LAT_DATA = senData.second[NS - 1];
-    const std::string LONG_DATA = senData.second[EW - 1];
-    
-    //Gets the degree conversion for the NMEA DATA 
-    float latitude = getDegreeConversion(LAT_DATA);
-    float longitude = getDegreeConversion(LONG_DATA);
+  std::optional<GPS::Position> ParserContext::parseLine(std::string_view line)
+  {
+    NoStats stats;
+    return parseLine(line, stats);
+  }
 
-    // Checks to see if the data has any invalid params
-    if (senData.second.size() < size)
-      throw std::invalid_argument("Missing Param");
+  template <typename Stats>
+  std::optional<GPS::Position> ParserContext::parseLine(std::string_view line, Stats & stats)
+  {
+    if(!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+
+    // ignore if not a well-formed sentence with a valid checksum
+    const auto scanStart = stats.now();
+    const ScanStatus status = scanSentence(line, view);
+    const auto scanEnd = stats.now();
+    stats.addTime(IngestStage::scan, scanStart, scanEnd);
+    stats.count(status);
+    if(status != ScanStatus::ok)
+      return std::nullopt;
+
+    // ignore if format not in supported formats, or if the fields are missing or have
+    // the wrong character classes; otherwise decode with the format's own decoder
+    const auto reject = [&](LineOutcome outcome, IngestStage stage) -> std::optional<GPS::Position> {
+      stats.addTime(stage, scanEnd, stats.now());
+      stats.count(outcome);
+      return std::nullopt;
+    };
+    if(!hasFormatCode(view.format))
+      return reject(LineOutcome::unsupportedFormat, IngestStage::validate);
+    return dispatchFormat(formatCode(view.format),
+                          [&](auto format) -> std::optional<GPS::Position> {
+                            if(!fieldsMatch<format()>(view))
+                              return reject(LineOutcome::invalidFields, IngestStage::validate);
+                            const auto decodeStart = stats.now();
+                            stats.addTime(IngestStage::validate, scanEnd, decodeStart);
+                            extractFields();
+                            const DecodeResult result = decodePosition<format()>(view);
+                            stats.addTime(IngestStage::decode, decodeStart, stats.now());
+                            if(!result){
+                              stats.count(LineOutcome::invalidData);
+                              return std::nullopt;
+                            }
+                            stats.count(LineOutcome::accepted);
+                            return result.position();
+                          },
+                          [&]() { return reject(LineOutcome::unsupportedFormat, IngestStage::validate); });
+  }
 
-    // Checks to see if the NMEA data is West or South and if it is invert it
-    if (senData.second[EW] == "W")
-      longitude = -fabs(longitude);
-    if (senData.second[NS] == "S") 
-      latitude = -fabs(latitude);
+  template std::optional<GPS::Position> ParserContext::parseLine(std::string_view, NoStats &);
+  template std::optional<GPS::Position> ParserContext::parseLine(std::string_view, IngestStats &);
 
-    // Return Pos
-    return GPS::Position(latitude,longitude,other); 
+  const SentenceData & ParserContext::sentenceData() const
+  {
+    return data;
   }
 
-  GPS::Position positionFromSentenceData(SentenceData senData)
+  void ParserContext::extractFields()
   {
-    const int GLL_SIZE = 5, GLL_NS_CHAR_LOC = 1, GLL_EW_CHAR_LOC = 3;
-    const int RMC_SIZE = 11, RMC_NS_CHAR_LOC = 3, RMC_EW_CHAR_LOC = 5;
-    const int GGA_SIZE = 14, GGA_NS_CHAR_LOC = 2, GGA_EW_CHAR_LOC = 4, GGA_OTHER = 8;
+    if(!view.allFieldsRecorded()){
+      data = extractSentenceData(view);
+      return;
+    }
 
-    // Checks if second part of sendata is empty. Return if it is
-    if (senData.second.empty())
-      throw std::invalid_argument("Filed Empty");
+    // Overwrite the strings left from the previous sentence, so that their storage is
+    // reused (short fields also fit within the strings themselves).
+    data.first.assign(view.format);
+    data.second.resize(view.fieldCount);
+    for(std::size_t i = 0; i < view.fieldCount; ++i)
+      data.second[i].assign(view.field(i));
+  }
 
-    //Need to fix these magic numbers. Calls and retuns the correct position for all supported formats
-    if(senData.first == "GLL")
-      return convertPosition(senData, GLL_SIZE, GLL_NS_CHAR_LOC, GLL_EW_CHAR_LOC);
-    else if(senData.first == "RMC")
-      return convertPosition(senData, RMC_SIZE, RMC_NS_CHAR_LOC, RMC_EW_CHAR_LOC); 
-    else if(senData.first == "GGA")
-      return convertPosition(senData, GGA_SIZE, GGA_NS_CHAR_LOC, GGA_EW_CHAR_LOC, std::stof(senData.second[GGA_OTHER]));
-    else
-      throw std::invalid_argument("Invalid syntax.");
+  std::optional<GPS::Position> positionFromLogLine(std::string_view line)
+  {
+    ParserContext context;
+    return context.parseLine(line);
   }
 
   Route routeFromLog(std::istream & fs)
   {
     Route ret;
-    for(std::string line; getline(fs, line);){
-      // ignore if not valid sentence
-      if(!isWellFormedSentence(line))
-        continue;
-      // ignore if checksum not valid
-      if(!hasValidChecksum(line))
-        continue;
-
-      SentenceData data = extractSentenceData(line);
-
-      // Checks if GLL strings are valid with REGEX and if they are not skip it.
-      if (data.first == "GLL") {
-				std::regex re("\\$GPGLL,[0-9]*.[0-9]*,N,[0-9]*.[0-9]*,W,[0-9]*\\*[A-Za-z0-9]{2,}");
-				if(!std::regex_match(line, re)) continue;
+    appendRouteFromLog(fs, ret);
+    return ret;
+  }
+
+  Route routeFromLog(std::istream & fs, IngestStats & stats)
+  {
+    Route ret;
+    appendRouteFromLog(fs, ret, stats);
+    return ret;
+  }
+
+  namespace
+  {
+    template <typename Stats>
+    Route routeFromLines(std::string_view log, Stats & stats)
+    {
+      Route ret;
+      appendRouteFromLogBuffer(log, ret, stats);
+      return ret;
+    }
+
+    // Splits the log into roughly equal chunks, each ending just after a newline (or at
+    // the end of the log), so that no line is divided between chunks.
+    std::vector<std::string_view> splitAtLineBoundaries(std::string_view log, std::size_t chunkCount)
+    {
+      std::vector<std::string_view> chunks;
+      const std::size_t targetSize = log.size() / chunkCount;
+      while(!log.empty()){
+        std::size_t end = log.size();
+        if(chunks.size() + 1 < chunkCount && targetSize < log.size()){
+          end = log.find('\n', targetSize);
+          end = (end == std::string_view::npos) ? log.size() : end + 1;
+        }
+        chunks.push_back(log.substr(0, end));
+        log.remove_prefix(end);
       }
-      // Checks if RMC strings are valid with REGEX and if they are not skip it.
-      else if (data.first == "RMC") {
-				std::regex re("\\$GPRMC,[0-9]*.[0-9]*,[AV],[0-9]*.[0-9]*,N,[0-9]*.[0-9]*,[EW],[0-9]*.[0-9]*,[0-9]*.[0-9]*,[0-9]*,,[AW]\\*[A-Za-z0-9]{2,}");
-				if(!std::regex_match(line, re)) continue;
+      return chunks;
+    }
+
+    template <typename Stats>
+    Route parseLogBuffer(std::string_view log, Stats & stats, unsigned int threads)
+    {
+      // Chunks smaller than this are not worth the cost of a thread.
+      const std::size_t MIN_CHUNK_SIZE = 16 * 1024;
+
+      if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      const std::size_t chunkCount = std::min<std::size_t>(threads, std::max<std::size_t>(1, log.size() / MIN_CHUNK_SIZE));
+      if(chunkCount <= 1)
+        return routeFromLines(log, stats);
+
+      // Parse every chunk but the first on a worker thread, and the first on this thread.
+      // Each worker records its own statistics, which are added together at the end.
+      const std::vector<std::string_view> chunks = splitAtLineBoundaries(log, chunkCount);
+      std::vector<Stats> workerStats(chunks.size() - 1);
+      std::vector<std::future<Route>> workers;
+      for(std::size_t i = 1; i < chunks.size(); ++i)
+        workers.push_back(std::async(std::launch::async, [&, i] { return routeFromLines(chunks[i], workerStats[i - 1]); }));
+
+      Route ret = routeFromLines(chunks.front(), stats);
+      std::vector<Route> parts;
+      std::size_t totalSize = ret.size();
+      for(std::future<Route> & worker : workers){
+        parts.push_back(worker.get());
+        totalSize += parts.back().size();
       }
-      // Checks if GGA strings are valid with REGEX and if they are not skip it.
-      else if (data.first == "GGA") {
-				std::regex re("\\$GPGGA,[0-9]*.[0-9]*,[0-9]*.[0-9]*,N,[0-9]*.[0-9]*,W,[0-9]*,[0-9]*,,-?[0-9]*.[0-9]*,M,,M,,\\*[A-Za-z0-9]{2,}");
-				if(!std::regex_match(line, re)) continue;
+      if constexpr (std::is_same_v<Stats, IngestStats>){
+        for(const IngestStats & part : workerStats)
+          stats += part;
       }
 
-      // ignore if format not in supported formats
-      if(std::find(std::begin(supported_formats), std::end(supported_formats), data.first) == std::end(supported_formats))
-        continue;
-      
-      // ignore if empty data
-      if(data.second.empty())
-        continue;
-      
-      ret.push_back(positionFromSentenceData(data));
+      // Join the chunk routes in file order.
+      ret.reserve(totalSize);
+      for(const Route & part : parts)
+        ret.insert(ret.end(), part.begin(), part.end());
+      return ret;
     }
-    return ret;
+  }
+
+  Route routeFromLogBuffer(std::string_view log, unsigned int threads)
+  {
+    NoStats stats;
+    return parseLogBuffer(log, stats, threads);
+  }
+
+  Route routeFromLogBuffer(std::string_view log, IngestStats & stats, unsigned int threads)
+  {
+    return parseLogBuffer(log, stats, threads);
+  }
+
+  Route routeFromLogFile(const std::string & path, unsigned int threads)
+  {
+    const GPS::MappedFile file(path);
+    return routeFromLogBuffer(file.contents(), threads);
+  }
+
+  Route routeFromLogFile(const std::string & path, IngestStats & stats, unsigned int threads)
+  {
+    const GPS::MappedFile file(path);
+    return routeFromLogBuffer(file.contents(), stats, threads);
   }
 }
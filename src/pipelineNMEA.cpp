@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "pipelineNMEA.h"
+#include "spscRing.h"
+
+namespace NMEA
+{
+  namespace
+  {
+    // A buffer of whole lines, or none at the end of the stream.
+    using Chunk = std::optional<std::string>;
+
+    // The route parsed from a buffer, or none at the end of the stream.
+    using Part = std::optional<Route>;
+
+    template <typename T>
+    using Rings = std::vector<std::unique_ptr<SPSCRing<T>>>;
+
+    // The first exception thrown by any stage, to be rethrown on the calling thread.
+    class StageError
+    {
+      public:
+        void set(std::exception_ptr error)
+        {
+          const std::lock_guard<std::mutex> lock(mutex);
+          if (!first)
+            first = error;
+          isSet.store(true, std::memory_order_release);
+        }
+
+        bool failed() const { return isSet.load(std::memory_order_acquire); }
+
+        // Only once every stage has stopped.
+        void rethrow() const
+        {
+          if (first)
+            std::rethrow_exception(first);
+        }
+
+      private:
+        std::mutex mutex;
+        std::exception_ptr first;
+        std::atomic<bool> isSet{false};
+    };
+
+    /* Reads the stream into buffers that end at line boundaries, and deals them to the
+     * parsers in turn, then sends every parser the end of the stream.  Reading stops early
+     * if any stage fails, but the end of the stream is always sent.
+     */
+    void readChunks(std::istream & in, std::size_t bufferSize, Rings<Chunk> & parsers, StageError & error)
+    {
+      std::size_t next = 0;
+      try {
+        std::string carry;
+        bool atEnd = false;
+        while (!atEnd && !error.failed()) {
+          // Read at least one whole line, after the partial line left from the last buffer.
+          std::string buffer = std::move(carry);
+          carry = std::string();
+          std::size_t lastNewline;
+          do {
+            const std::size_t used = buffer.size();
+            buffer.resize(used + bufferSize);
+            in.read(buffer.data() + used, bufferSize);
+            buffer.resize(used + in.gcount());
+            atEnd = !in;
+            lastNewline = buffer.rfind('\n');
+          } while (lastNewline == std::string::npos && !atEnd);
+
+          if (!atEnd) {
+            carry.assign(buffer, lastNewline + 1);
+            buffer.resize(lastNewline + 1);
+          }
+          if (!buffer.empty()) {
+            parsers[next]->push(std::move(buffer));
+            next = (next + 1) % parsers.size();
+          }
+        }
+      }
+      catch (...) {
+        error.set(std::current_exception());
+      }
+
+      for (std::size_t i = 0; i < parsers.size(); ++i)
+        parsers[(next + i) % parsers.size()]->push(std::nullopt);
+    }
+
+    /* Parses each buffer into a route, then sends the end of the stream.  Once any stage
+     * has failed, the end is sent at once, so that the collector does not wait for a route
+     * that will never come, but the remaining buffers are still taken so that the reader is
+     * never left waiting for space.
+     */
+    void parseChunks(SPSCRing<Chunk> & input, SPSCRing<Part> & output, StageError & error)
+    {
+      bool ended = false;
+      while (Chunk chunk = input.pop()) {
+        if (ended)
+          continue;
+        if (!error.failed()) {
+          try {
+            Route route;
+            appendRouteFromLogBuffer(*chunk, route);
+            output.push(std::move(route));
+            continue;
+          }
+          catch (...) {
+            error.set(std::current_exception());
+          }
+        }
+        output.push(std::nullopt);
+        ended = true;
+      }
+      if (!ended)
+        output.push(std::nullopt);
+    }
+
+    // Waits for the end of a parser's output, discarding any routes before it.
+    void drain(SPSCRing<Part> & output)
+    {
+      while (output.pop())
+        ;
+    }
+  }
+
+  Route routeFromLogPipelined(std::istream & in, const PipelineOptions & options)
+  {
+    if (options.bufferSize == 0)
+      throw std::invalid_argument("The buffer size of a pipeline must be positive.");
+
+    const unsigned int workers = options.workers > 0 ? options.workers
+                                                     : std::max(2u, std::thread::hardware_concurrency()) - 1;
+    Rings<Chunk> inputs;
+    Rings<Part> outputs;
+    for (unsigned int i = 0; i < workers; ++i) {
+      inputs.push_back(std::make_unique<SPSCRing<Chunk>>(options.queueDepth));
+      outputs.push_back(std::make_unique<SPSCRing<Part>>(options.queueDepth));
+    }
+
+    // The parsers are started before the reader, so that if a thread cannot be started,
+    // the parsers already running can be stopped through their (still empty) inputs.
+    StageError error;
+    std::vector<std::thread> threads;
+    threads.reserve(workers + 1);
+    try {
+      for (unsigned int i = 0; i < workers; ++i)
+        threads.emplace_back(parseChunks, std::ref(*inputs[i]), std::ref(*outputs[i]), std::ref(error));
+      threads.emplace_back(readChunks, std::ref(in), options.bufferSize, std::ref(inputs), std::ref(error));
+    }
+    catch (...) {
+      error.set(std::current_exception());
+      for (std::size_t i = 0; i < threads.size(); ++i)
+        inputs[i]->push(std::nullopt);
+      for (std::size_t i = 0; i < threads.size(); ++i)
+        drain(*outputs[i]);
+      for (std::thread & thread : threads)
+        thread.join();
+      error.rethrow();
+    }
+
+    // Collect the routes in the order in which the buffers were dealt.  When the first
+    // end-of-stream arrives, every route has been collected, unless a stage has failed.
+    Route ret;
+    std::size_t next = 0;
+    while (Part part = outputs[next]->pop()) {
+      if (!error.failed()) {
+        try {
+          if (ret.empty())
+            ret = std::move(*part);
+          else
+            ret.insert(ret.end(), part->begin(), part->end());
+        }
+        catch (...) {
+          error.set(std::current_exception());
+        }
+      }
+      next = (next + 1) % workers;
+    }
+
+    // Wait for the end of every other parser, so that none is left waiting for space.
+    for (std::size_t i = 0; i < workers; ++i) {
+      if (i != next)
+        drain(*outputs[i]);
+    }
+    for (std::thread & thread : threads)
+      thread.join();
+    error.rethrow();
+    return ret;
+  }
+
+  Route routeFromLogFilePipelined(const std::string & path, const PipelineOptions & options)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      throw std::runtime_error("Cannot open " + path);
+    return routeFromLogPipelined(in, options);
+  }
+}
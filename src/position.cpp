@@ -1,14 +1,31 @@
 #include <cassert>
 #include <cmath>
-#include <sstream>
 #include <stdexcept>
 
 #include "geometry.h"
 #include "earth.h"
+#include "formatPosition.h"
+#include "parseDecimal.h"
 #include "position.h"
 
 namespace GPS
 {
+  namespace
+  {
+      double decimalFromString(const std::string & str)
+      {
+          double value;
+          if (!parseDecimal(str, value))
+              throw std::invalid_argument("\"" + str + "\" is not a decimal number.");
+          return value;
+      }
+
+      bool inRange(degrees lat, degrees lon)
+      {
+          return std::abs(lat) <= poleLatitude && std::abs(lon) <= antiMeridianLongitude;
+      }
+  }
+
   Position::Position(degrees lat, degrees lon, metres ele)
   {
       if (std::abs(lat) > poleLatitude)
@@ -22,15 +39,22 @@ namespace GPS
       this->ele = ele;
   }
 
+  std::optional<Position> Position::fromDegrees(degrees lat, degrees lon, metres ele) noexcept
+  {
+      if (!inRange(lat, lon))
+          return std::nullopt;
+      return Position(lat, lon, ele);
+  }
+
   Position::Position(std::string latStr,
                      std::string lonStr,
                      std::string eleStr)
-      : Position(std::stod(latStr), std::stod(lonStr), std::stod(eleStr)) {}
+      : Position(decimalFromString(latStr), decimalFromString(lonStr), decimalFromString(eleStr)) {}
 
   Position::Position(std::string ddmLatStr, char northing,
                      std::string ddmLonStr, char easting,
                      std::string eleStr)
-      : Position(ddmTodd(ddmLatStr), ddmTodd(ddmLonStr), std::stod(eleStr))
+      : Position(ddmTodd(ddmLatStr), ddmTodd(ddmLonStr), decimalFromString(eleStr))
   {
       if (lat < 0)
           throw std::invalid_argument("Latitude values must be positive when accompanied by a N/S bearing.");
@@ -71,15 +95,11 @@ namespace GPS
 
   std::string Position::toString(bool includeElevation) const
   {
-      std::ostringstream oss;
-
-      oss <<  "lat=\"" << lat << "\"";
-      oss << " lon=\"" << lon << "\"";
-      if (includeElevation) {
-          oss << " ele=\"" << ele << "\"";
-      }
+      PositionFormat format;
+      format.includeElevation = includeElevation;
 
-      return oss.str();
+      char buffer[maxFormattedPositionLength];
+      return std::string(buffer, formatPosition(buffer, buffer + sizeof(buffer), *this, format).ptr);
   }
 
   metres Position::distanceBetween(Position p1, Position p2)
@@ -98,9 +118,9 @@ namespace GPS
 
   degrees ddmTodd(std::string ddmStr)
   {
-      double ddm  = std::stod(ddmStr);
-      double degs = std::floor(ddm / 100);
-      double mins = ddm - 100 * degs;
-      return degs + mins / 60.0; // converts minutes (1/60th) to decimal fractions of a degree
+      degrees dd;
+      if (!parseDDM(ddmStr, dd))
+          throw std::invalid_argument("\"" + ddmStr + "\" is not a DDM angle.");
+      return dd;
   }
 }
@@ -0,0 +1,86 @@
+#include "routeColumns.h"
+
+namespace NMEA
+{
+  RouteColumns::RouteColumns(const Route & route)
+  {
+    reserve(route.size());
+    for (const GPS::Position & pos : route)
+      push_back(pos);
+  }
+
+  std::size_t RouteColumns::size() const
+  {
+    return lats.size();
+  }
+
+  bool RouteColumns::empty() const
+  {
+    return lats.empty();
+  }
+
+  void RouteColumns::reserve(std::size_t n)
+  {
+    lats.reserve(n);
+    lons.reserve(n);
+    eles.reserve(n);
+  }
+
+  void RouteColumns::clear()
+  {
+    lats.clear();
+    lons.clear();
+    eles.clear();
+  }
+
+  void RouteColumns::push_back(const GPS::Position & pos)
+  {
+    push_back(pos.latitude(), pos.longitude(), pos.elevation());
+  }
+
+  void RouteColumns::push_back(GPS::degrees lat, GPS::degrees lon, GPS::metres ele)
+  {
+    lats.push_back(lat);
+    lons.push_back(lon);
+    eles.push_back(ele);
+  }
+
+  const std::vector<GPS::degrees> & RouteColumns::latitudes() const
+  {
+    return lats;
+  }
+
+  const std::vector<GPS::degrees> & RouteColumns::longitudes() const
+  {
+    return lons;
+  }
+
+  const std::vector<GPS::metres> & RouteColumns::elevations() const
+  {
+    return eles;
+  }
+
+  GPS::Position RouteColumns::operator[](std::size_t i) const
+  {
+    return GPS::Position(lats[i], lons[i], eles[i]);
+  }
+
+  RouteColumns::const_iterator RouteColumns::begin() const
+  {
+    return const_iterator(this, 0);
+  }
+
+  RouteColumns::const_iterator RouteColumns::end() const
+  {
+    return const_iterator(this, size());
+  }
+
+  Route RouteColumns::toRoute() const
+  {
+    Route ret;
+    ret.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i)
+      ret.push_back((*this)[i]);
+    return ret;
+  }
+}
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cmath>
+
+#include "earth.h"
+#include "routeDistance.h"
+
+// On x86-64 Linux, the batch kernels are also compiled for AVX2 and chosen at load time.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+  #define BATCH_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+  #define BATCH_KERNEL
+#endif
+
+namespace GPS
+{
+  namespace
+  {
+    // Points are processed in blocks small enough for the intermediate arrays to stay in L1 cache.
+    const std::size_t BLOCK = 256;
+
+    // The same value as GPS::pi, which is not a constant expression.
+    constexpr double PI = 3.141592653589793;
+
+    // pi/2 split into a high part with trailing zero bits, and the remainder, so that
+    // pi/2 - x can be computed without cancellation error.
+    constexpr double PIO2_HI = 1.57079632673412561417e+00;
+    constexpr double PIO2_LO = 6.07710050650619224932e-11;
+    constexpr double PIO2    = 1.57079632679489661923;
+    constexpr double PIO4    = 0.785398163397448309616;
+
+    // Minimax polynomial coefficients for sin and cos on [-pi/4,pi/4], and for asin on
+    // [0,0.5], from fdlibm.
+    constexpr double S1 = -1.66666666666666324348e-01, S2 =  8.33333333332248946124e-03,
+                     S3 = -1.98412698298579493134e-04, S4 =  2.75573137070700676789e-06,
+                     S5 = -2.50507602534068634195e-08, S6 =  1.58969099521155010221e-10;
+
+    constexpr double C1 =  4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                     C3 =  2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                     C5 =  2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+
+    constexpr double PS0 =  1.66666666666666657415e-01, PS1 = -3.25565818622400915405e-01,
+                     PS2 =  2.01212532134862925881e-01, PS3 = -4.00555345006794114027e-02,
+                     PS4 =  7.91534994289814532176e-04, PS5 =  3.47933107596021167570e-05,
+                     QS1 = -2.40339491173441421878e+00, QS2 =  2.02094576023350569471e+00,
+                     QS3 = -6.88283971605453293030e-01, QS4 =  7.70381505559019352791e-02;
+
+    // The kernels below are branch-free (both alternatives are evaluated, then one is
+    // selected), so that the loops calling them can be vectorised.
+
+    // sin(x) for |x| <= pi/4
+    inline double kernelSin(double x)
+    {
+        const double z = x * x;
+        return x + x * z * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+    }
+
+    // cos(x) for |x| <= pi/4
+    inline double kernelCos(double x)
+    {
+        const double z = x * x;
+        return 1.0 - 0.5 * z + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    }
+
+    // sin(a) for 0 <= a <= pi/2
+    inline double sinQuadrant(double a)
+    {
+        const double near = kernelSin(a);
+        const double far  = kernelCos((PIO2_HI - a) + PIO2_LO);
+        return a <= PIO4 ? near : far;
+    }
+
+    // cos(a) for 0 <= a <= pi/2
+    inline double cosQuadrant(double a)
+    {
+        const double near = kernelCos(a);
+        const double far  = kernelSin((PIO2_HI - a) + PIO2_LO);
+        return a <= PIO4 ? near : far;
+    }
+
+    // sin^2(x) for |x| <= pi, using sin^2(x) = sin^2(pi - |x|)
+    inline double sinSqrHalfTurn(double x)
+    {
+        double a = std::fabs(x);
+        a = a > PIO2 ? (2 * PIO2_HI - a) + 2 * PIO2_LO : a;
+        const double s = sinQuadrant(a);
+        return s * s;
+    }
+
+    inline double asinRational(double t)
+    {
+        const double p = t * (PS0 + t * (PS1 + t * (PS2 + t * (PS3 + t * (PS4 + t * PS5)))));
+        const double q = 1.0 + t * (QS1 + t * (QS2 + t * (QS3 + t * QS4)));
+        return p / q;
+    }
+
+    // asin(s) for 0 <= s <= 1
+    inline double asinUnit(double s)
+    {
+        const double small = s + s * asinRational(s * s);
+
+        // asin(s) = pi/2 - 2 asin(sqrt((1-s)/2))
+        const double t = (1.0 - s) * 0.5;
+        const double r = std::sqrt(t);
+        const double large = PIO2_HI - (2.0 * (r + r * asinRational(t)) - PIO2_LO);
+
+        return s < 0.5 ? small : large;
+    }
+
+    inline radians toRadians(degrees d)
+    {
+        return d * PI / 180.0; // as degToRad()
+    }
+
+    // The haversine of the central angle, given the latitudes' cosines.
+    inline double haversine(radians lat1, radians lat2, double cosLat1, double cosLat2, radians lon1, radians lon2)
+    {
+        return sinSqrHalfTurn((lat2 - lat1) / 2) + cosLat1 * cosLat2 * sinSqrHalfTurn((lon2 - lon1) / 2);
+    }
+
+    // The distance subtended by a central angle with haversine h.
+    inline metres arcLength(double h, metres diameter)
+    {
+        return diameter * asinUnit(std::sqrt(std::min(h, 1.0))); // rounding may push h just above 1
+    }
+
+    // Distances between consecutive points of a block of 2 <= n <= BLOCK+1 points.
+    BATCH_KERNEL
+    void segmentBlock(const degrees * lats, const degrees * lons, std::size_t n, metres diameter, metres * distances)
+    {
+        radians phi[BLOCK + 1], lambda[BLOCK + 1];
+        double  cosPhi[BLOCK + 1], h[BLOCK];
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            phi[i] = toRadians(lats[i]);
+            lambda[i] = toRadians(lons[i]);
+            cosPhi[i] = cosQuadrant(std::fabs(phi[i]));
+        }
+
+        // Each segment ends where the next begins.
+        const radians * phiEnd = phi + 1;
+        const radians * lambdaEnd = lambda + 1;
+        const double  * cosPhiEnd = cosPhi + 1;
+        const std::size_t segments = n - 1;
+        #pragma omp simd
+        for (std::size_t i = 0; i < segments; ++i)
+            h[i] = haversine(phi[i], phiEnd[i], cosPhi[i], cosPhiEnd[i], lambda[i], lambdaEnd[i]);
+
+        // A separate pass, as GCC does not vectorise the whole computation as one loop.
+        #pragma omp simd
+        for (std::size_t i = 0; i < segments; ++i)
+            distances[i] = arcLength(h[i], diameter);
+    }
+
+    // Distances from one point to each of a block of n <= BLOCK points.
+    BATCH_KERNEL
+    void distancesBlock(radians originLat, radians originLon, double originCosLat,
+                        const degrees * lats, const degrees * lons, std::size_t n, metres diameter, metres * distances)
+    {
+        double h[BLOCK];
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const radians phi = toRadians(lats[i]);
+            h[i] = haversine(originLat, phi, originCosLat, cosQuadrant(std::fabs(phi)), originLon, toRadians(lons[i]));
+        }
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+            distances[i] = arcLength(h[i], diameter);
+    }
+  }
+
+  void segmentDistances(const degrees * lats, const degrees * lons, std::size_t n, metres * distances)
+  {
+      const metres diameter = 2 * Earth::meanRadius;
+
+      // Consecutive blocks share one point, so that every segment is computed exactly once.
+      for (std::size_t start = 0; start + 1 < n; start += BLOCK)
+      {
+          const std::size_t count = std::min(BLOCK + 1, n - start);
+          segmentBlock(lats + start, lons + start, count, diameter, distances + start);
+      }
+  }
+
+  metres routeLength(const degrees * lats, const degrees * lons, std::size_t n)
+  {
+      metres distances[BLOCK];
+      metres total = 0;
+      const metres diameter = 2 * Earth::meanRadius;
+      for (std::size_t start = 0; start + 1 < n; start += BLOCK)
+      {
+          const std::size_t count = std::min(BLOCK + 1, n - start);
+          segmentBlock(lats + start, lons + start, count, diameter, distances);
+          for (std::size_t i = 0; i + 1 < count; ++i)
+              total += distances[i];
+      }
+      return total;
+  }
+
+  void distancesFrom(const Position & origin, const degrees * lats, const degrees * lons,
+                     std::size_t n, metres * distances)
+  {
+      const metres diameter = 2 * Earth::meanRadius;
+      const radians originLat = toRadians(origin.latitude());
+      const radians originLon = toRadians(origin.longitude());
+      const double originCosLat = std::cos(originLat);
+      for (std::size_t start = 0; start < n; start += BLOCK)
+      {
+          const std::size_t count = std::min(BLOCK, n - start);
+          distancesBlock(originLat, originLon, originCosLat, lats + start, lons + start, count, diameter, distances + start);
+      }
+  }
+}
+
+namespace NMEA
+{
+  namespace
+  {
+    // Gathers the coordinates of route[start, start+count) into the arrays.
+    template <typename RouteContainer>
+    void gather(const RouteContainer & route, std::size_t start, std::size_t count, GPS::degrees * lats, GPS::degrees * lons)
+    {
+      for (std::size_t i = 0; i < count; ++i) {
+        lats[i] = route[start + i].latitude();
+        lons[i] = route[start + i].longitude();
+      }
+    }
+
+    const std::size_t GATHER_BLOCK = 1024;
+
+    template <typename RouteContainer>
+    std::vector<GPS::metres> gatheredSegmentDistances(const RouteContainer & route)
+    {
+      std::vector<GPS::metres> distances(route.empty() ? 0 : route.size() - 1);
+      GPS::degrees lats[GATHER_BLOCK + 1], lons[GATHER_BLOCK + 1];
+      for (std::size_t start = 0; start + 1 < route.size(); start += GATHER_BLOCK) {
+        const std::size_t count = std::min(GATHER_BLOCK + 1, route.size() - start);
+        gather(route, start, count, lats, lons);
+        GPS::segmentDistances(lats, lons, count, distances.data() + start);
+      }
+      return distances;
+    }
+
+    template <typename RouteContainer>
+    GPS::metres gatheredRouteLength(const RouteContainer & route)
+    {
+      GPS::metres total = 0;
+      GPS::degrees lats[GATHER_BLOCK + 1], lons[GATHER_BLOCK + 1];
+      for (std::size_t start = 0; start + 1 < route.size(); start += GATHER_BLOCK) {
+        const std::size_t count = std::min(GATHER_BLOCK + 1, route.size() - start);
+        gather(route, start, count, lats, lons);
+        total += GPS::routeLength(lats, lons, count);
+      }
+      return total;
+    }
+
+    template <typename RouteContainer>
+    std::vector<GPS::metres> gatheredDistancesFrom(const GPS::Position & origin, const RouteContainer & route)
+    {
+      std::vector<GPS::metres> distances(route.size());
+      GPS::degrees lats[GATHER_BLOCK], lons[GATHER_BLOCK];
+      for (std::size_t start = 0; start < route.size(); start += GATHER_BLOCK) {
+        const std::size_t count = std::min(GATHER_BLOCK, route.size() - start);
+        gather(route, start, count, lats, lons);
+        GPS::distancesFrom(origin, lats, lons, count, distances.data() + start);
+      }
+      return distances;
+    }
+  }
+
+  std::vector<GPS::metres> segmentDistances(const RouteColumns & route)
+  {
+    std::vector<GPS::metres> distances(route.empty() ? 0 : route.size() - 1);
+    GPS::segmentDistances(route.latitudes().data(), route.longitudes().data(), route.size(), distances.data());
+    return distances;
+  }
+
+  std::vector<GPS::metres> segmentDistances(const Route & route)
+  {
+    return gatheredSegmentDistances(route);
+  }
+
+  std::vector<GPS::metres> segmentDistances(const CompactRoute & route)
+  {
+    return gatheredSegmentDistances(route);
+  }
+
+  GPS::metres routeLength(const RouteColumns & route)
+  {
+    return GPS::routeLength(route.latitudes().data(), route.longitudes().data(), route.size());
+  }
+
+  GPS::metres routeLength(const Route & route)
+  {
+    return gatheredRouteLength(route);
+  }
+
+  GPS::metres routeLength(const CompactRoute & route)
+  {
+    return gatheredRouteLength(route);
+  }
+
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const RouteColumns & route)
+  {
+    std::vector<GPS::metres> distances(route.size());
+    GPS::distancesFrom(origin, route.latitudes().data(), route.longitudes().data(), route.size(), distances.data());
+    return distances;
+  }
+
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const Route & route)
+  {
+    return gatheredDistancesFrom(origin, route);
+  }
+
+  std::vector<GPS::metres> distancesFrom(const GPS::Position & origin, const CompactRoute & route)
+  {
+    return gatheredDistancesFrom(origin, route);
+  }
+}
@@ -0,0 +1,219 @@
+#include <atomic>
+#include <stdexcept>
+
+#include "scanKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define NMEA_X86_KERNELS 1
+  #include <immintrin.h>
+#endif
+
+namespace NMEA
+{
+  namespace
+  {
+    struct Kernel
+    {
+      ScanKernel kind;
+      std::uint8_t (*xorReduce)(const char *, std::size_t);
+      std::size_t (*findDelimiters)(const char *, std::size_t, std::uint32_t *, std::size_t);
+    };
+
+    bool isDelimiter(char c)
+    {
+      return c == ',' || c == '*' || c == '$';
+    }
+
+    std::uint8_t scalarXorReduce(const char * data, std::size_t length)
+    {
+      std::uint8_t result = 0;
+      for (std::size_t i = 0; i < length; ++i)
+        result ^= std::uint8_t(data[i]);
+      return result;
+    }
+
+    std::size_t scalarFindDelimiters(const char * data, std::size_t length,
+                                     std::uint32_t * offsets, std::size_t capacity)
+    {
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < length; ++i) {
+        if (isDelimiter(data[i])) {
+          if (count < capacity)
+            offsets[count] = std::uint32_t(i);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    // Records the offsets of the set bits of a comparison mask for a block starting at 'base'.
+    inline std::size_t recordMask(std::uint32_t mask, std::size_t base,
+                                  std::uint32_t * offsets, std::size_t capacity, std::size_t count)
+    {
+      while (mask != 0) {
+        if (count < capacity)
+          offsets[count] = std::uint32_t(base + __builtin_ctz(mask));
+        ++count;
+        mask &= mask - 1;
+      }
+      return count;
+    }
+
+#ifdef NMEA_X86_KERNELS
+
+    __attribute__((target("sse2")))
+    std::uint8_t sse2XorReduce(const char * data, std::size_t length)
+    {
+      const std::size_t BLOCK = 16;
+      __m128i acc = _mm_setzero_si128();
+      std::size_t i = 0;
+      for (; i + BLOCK <= length; i += BLOCK)
+        acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+
+      // Fold the 16 accumulated bytes down to one.
+      acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+      acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+      acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+      acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+      const std::uint8_t folded = std::uint8_t(_mm_cvtsi128_si32(acc));
+
+      return folded ^ scalarXorReduce(data + i, length - i);
+    }
+
+    __attribute__((target("sse2")))
+    std::size_t sse2FindDelimiters(const char * data, std::size_t length,
+                                   std::uint32_t * offsets, std::size_t capacity)
+    {
+      const std::size_t BLOCK = 16;
+      const __m128i comma = _mm_set1_epi8(','), star = _mm_set1_epi8('*'), dollar = _mm_set1_epi8('$');
+      std::size_t count = 0, i = 0;
+      for (; i + BLOCK <= length; i += BLOCK) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma),
+                                          _mm_or_si128(_mm_cmpeq_epi8(bytes, star), _mm_cmpeq_epi8(bytes, dollar)));
+        count = recordMask(std::uint32_t(_mm_movemask_epi8(hits)), i, offsets, capacity, count);
+      }
+      for (; i < length; ++i) {
+        if (isDelimiter(data[i])) {
+          if (count < capacity)
+            offsets[count] = std::uint32_t(i);
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    __attribute__((target("avx2")))
+    std::uint8_t avx2XorReduce(const char * data, std::size_t length)
+    {
+      const std::size_t BLOCK = 32;
+      __m256i acc = _mm256_setzero_si256();
+      std::size_t i = 0;
+      for (; i + BLOCK <= length; i += BLOCK)
+        acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+
+      // Fold the 32 accumulated bytes down to one.
+      __m128i half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+      half = _mm_xor_si128(half, _mm_srli_si128(half, 8));
+      half = _mm_xor_si128(half, _mm_srli_si128(half, 4));
+      half = _mm_xor_si128(half, _mm_srli_si128(half, 2));
+      half = _mm_xor_si128(half, _mm_srli_si128(half, 1));
+      const std::uint8_t folded = std::uint8_t(_mm_cvtsi128_si32(half));
+
+      return folded ^ sse2XorReduce(data + i, length - i);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t avx2FindDelimiters(const char * data, std::size_t length,
+                                   std::uint32_t * offsets, std::size_t capacity)
+    {
+      const std::size_t BLOCK = 32;
+      const __m256i comma = _mm256_set1_epi8(','), star = _mm256_set1_epi8('*'), dollar = _mm256_set1_epi8('$');
+      std::size_t count = 0, i = 0;
+      for (; i + BLOCK <= length; i += BLOCK) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(bytes, star), _mm256_cmpeq_epi8(bytes, dollar)));
+        count = recordMask(std::uint32_t(_mm256_movemask_epi8(hits)), i, offsets, capacity, count);
+      }
+
+      // The tail (fewer than 32 bytes) is finished with the SSE2 kernel.
+      if (i < length) {
+        const std::size_t stored = count < capacity ? count : capacity;
+        const std::size_t tail = sse2FindDelimiters(data + i, length - i, offsets + stored, capacity - stored);
+        for (std::size_t k = stored; k < capacity && k < stored + tail; ++k)
+          offsets[k] += std::uint32_t(i);
+        count += tail;
+      }
+      return count;
+    }
+
+#endif
+
+    const Kernel SCALAR_KERNEL = { ScanKernel::scalar, scalarXorReduce, scalarFindDelimiters };
+#ifdef NMEA_X86_KERNELS
+    const Kernel SSE2_KERNEL   = { ScanKernel::sse2,   sse2XorReduce,   sse2FindDelimiters };
+    const Kernel AVX2_KERNEL   = { ScanKernel::avx2,   avx2XorReduce,   avx2FindDelimiters };
+#endif
+
+    const Kernel * kernelFor(ScanKernel kind)
+    {
+      switch (kind)
+      {
+        case ScanKernel::scalar: return &SCALAR_KERNEL;
+#ifdef NMEA_X86_KERNELS
+        case ScanKernel::sse2:   return __builtin_cpu_supports("sse2") ? &SSE2_KERNEL : nullptr;
+        case ScanKernel::avx2:   return __builtin_cpu_supports("avx2") ? &AVX2_KERNEL : nullptr;
+#endif
+        default:                 return nullptr;
+      }
+    }
+
+    const Kernel * bestKernel()
+    {
+#ifdef NMEA_X86_KERNELS
+      __builtin_cpu_init(); // may run before the CPU model is initialised, during static initialisation
+#endif
+      for (ScanKernel kind : { ScanKernel::avx2, ScanKernel::sse2 }) {
+        if (const Kernel * kernel = kernelFor(kind))
+          return kernel;
+      }
+      return &SCALAR_KERNEL;
+    }
+
+    std::atomic<const Kernel *> & activeKernel()
+    {
+      static std::atomic<const Kernel *> kernel(bestKernel());
+      return kernel;
+    }
+  }
+
+  bool isScanKernelSupported(ScanKernel kind)
+  {
+    return kernelFor(kind) != nullptr;
+  }
+
+  ScanKernel selectedScanKernel()
+  {
+    return activeKernel().load(std::memory_order_relaxed)->kind;
+  }
+
+  void selectScanKernel(ScanKernel kind)
+  {
+    const Kernel * kernel = kernelFor(kind);
+    if (kernel == nullptr)
+      throw std::invalid_argument("The requested scan kernel is not supported on this CPU.");
+    activeKernel().store(kernel, std::memory_order_relaxed);
+  }
+
+  std::uint8_t xorReduce(const char * data, std::size_t length)
+  {
+    return activeKernel().load(std::memory_order_relaxed)->xorReduce(data, length);
+  }
+
+  std::size_t findDelimiters(const char * data, std::size_t length,
+                             std::uint32_t * offsets, std::size_t capacity)
+  {
+    return activeKernel().load(std::memory_order_relaxed)->findDelimiters(data, length, offsets, capacity);
+  }
+}
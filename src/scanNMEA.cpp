@@ -0,0 +1,85 @@
+#include <algorithm>
+
+#include "scanKernels.h"
+#include "scanNMEA.h"
+
+namespace NMEA
+{
+  namespace
+  {
+    // Returns the value of a hexadecimal digit, or -1 for any other character.
+    int hexValue(char c)
+    {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      return -1;
+    }
+
+    bool isUpperAlpha(char c)
+    {
+      return c >= 'A' && c <= 'Z';
+    }
+  }
+
+  ScanStatus scanSentence(std::string_view sen, SentenceView & view)
+  {
+    // PREFIX_LENGTH = length of NMEA prefix ($GP)
+    // FORMAT_LENGTH = length of sentence format string (GLL)
+    // SUFFIX_LENGTH = length of checksum suffix (*FF)
+    const std::size_t PREFIX_LENGTH = 3, FORMAT_LENGTH = 3, SUFFIX_LENGTH = 3;
+    const std::size_t MIN_LENGTH = PREFIX_LENGTH + FORMAT_LENGTH + SUFFIX_LENGTH;
+
+    view.sentence = sen;
+    view.fieldCount = 0;
+
+    if (sen.length() < MIN_LENGTH)
+      return ScanStatus::tooShort;
+
+    if (sen[0] != '$' || sen[1] != 'G' || sen[2] != 'P')
+      return ScanStatus::missingPrefix;
+
+    const std::size_t FORMAT_END = PREFIX_LENGTH + FORMAT_LENGTH;
+    if (!isUpperAlpha(sen[3]) || !isUpperAlpha(sen[4]) || !isUpperAlpha(sen[5]))
+      return ScanStatus::invalidFormat;
+    if (sen[FORMAT_END] != ',' && sen[FORMAT_END] != '*')
+      return ScanStatus::invalidFormat;
+
+    const std::size_t STAR_LOC = sen.length() - SUFFIX_LENGTH;
+    if (sen[STAR_LOC] != '*')
+      return ScanStatus::missingChecksum;
+
+    const int high = hexValue(sen[STAR_LOC + 1]), low = hexValue(sen[STAR_LOC + 2]);
+    if (high < 0 || low < 0)
+      return ScanStatus::invalidChecksum;
+
+    // Everything between the '$' and the '*' contributes to the checksum.
+    const std::uint8_t checksum = xorReduce(sen.data() + 1, STAR_LOC - 1);
+
+    // Locate the delimiters within the data fields; only commas are permitted.
+    const std::size_t CAPACITY = SentenceView::maxFields + 1;
+    const std::size_t delimiterCount = findDelimiters(sen.data() + FORMAT_END, STAR_LOC - FORMAT_END,
+                                                      view.delimiters.data(), CAPACITY);
+    const std::size_t recorded = std::min(delimiterCount, CAPACITY);
+    for (std::size_t i = 0; i < recorded; ++i) {
+      view.delimiters[i] += std::uint32_t(FORMAT_END);
+      if (sen[view.delimiters[i]] != ',')
+        return ScanStatus::reservedCharacter;
+    }
+    if (delimiterCount > CAPACITY) {
+      // Too many fields to record, so check the unrecorded remainder directly.
+      const std::size_t restStart = view.delimiters[CAPACITY - 1] + 1;
+      if (sen.substr(restStart, STAR_LOC - restStart).find_first_of("$*") != std::string_view::npos)
+        return ScanStatus::reservedCharacter;
+    }
+    if (delimiterCount <= SentenceView::maxFields)
+      view.delimiters[delimiterCount] = std::uint32_t(STAR_LOC);
+
+    view.format = sen.substr(PREFIX_LENGTH, FORMAT_LENGTH);
+    view.fieldCount = delimiterCount;
+    view.declaredChecksum = std::uint8_t(high * 16 + low);
+    view.computedChecksum = checksum;
+
+    return view.hasValidChecksum() ? ScanStatus::ok : ScanStatus::checksumMismatch;
+  }
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "earth.h"
+#include "geometry.h"
+#include "simplifyRoute.h"
+
+namespace GPS
+{
+  metres distanceFromSegment(const Position & pos, const Position & start, const Position & end)
+  {
+    // Project onto a local plane (in metres) with its origin at the start of the segment.
+    const degrees midLatitude = (start.latitude() + end.latitude()) / 2;
+    const degrees latPerMetre = Earth::latitudeSubtendedBy(1);
+    const degrees lonPerMetre = Earth::longitudeSubtendedBy(1, midLatitude);
+    const auto projectX = [lonPerMetre](degrees lon) { return lonPerMetre == 0 ? 0 : lon / lonPerMetre; };
+
+    const degrees segmentLon = normaliseDeg(end.longitude() - start.longitude());
+    const double segmentX = projectX(segmentLon);
+    const double segmentY = (end.latitude() - start.latitude()) / latPerMetre;
+    const double posX = projectX(normaliseDeg(pos.longitude() - start.longitude()));
+    const double posY = (pos.latitude() - start.latitude()) / latPerMetre;
+
+    // The fraction of the way along the segment of the nearest point.
+    const double lengthSqr = segmentX * segmentX + segmentY * segmentY;
+    const double t = lengthSqr == 0 ? 0 : std::clamp((posX * segmentX + posY * segmentY) / lengthSqr, 0.0, 1.0);
+
+    const Position nearest(start.latitude() + t * (end.latitude() - start.latitude()),
+                           normaliseDeg(start.longitude() + t * segmentLon));
+    return Position::distanceBetween(pos, nearest);
+  }
+}
+
+namespace NMEA
+{
+  namespace
+  {
+    void checkTolerance(GPS::metres tolerance)
+    {
+      if (!(tolerance >= 0))
+        throw std::invalid_argument("The simplification tolerance must not be negative.");
+    }
+  }
+
+  Route simplifyRoute(const Route & route, GPS::metres tolerance)
+  {
+    checkTolerance(tolerance);
+    if (route.size() <= 2)
+      return route;
+
+    std::vector<bool> kept(route.size(), false);
+    kept.front() = kept.back() = true;
+
+    // Ranges [first, last] still to be simplified, kept on a stack rather than by recursion
+    // so that long routes cannot exhaust the call stack.
+    std::vector<std::pair<std::size_t, std::size_t>> ranges = { {0, route.size() - 1} };
+    while (!ranges.empty()) {
+      const auto [first, last] = ranges.back();
+      ranges.pop_back();
+
+      // Find the position furthest from the segment that would replace the range.
+      GPS::metres furthestDistance = 0;
+      std::size_t furthest = first;
+      for (std::size_t i = first + 1; i < last; ++i) {
+        const GPS::metres distance = GPS::distanceFromSegment(route[i], route[first], route[last]);
+        if (distance > furthestDistance) {
+          furthestDistance = distance;
+          furthest = i;
+        }
+      }
+
+      if (furthestDistance > tolerance) {
+        kept[furthest] = true;
+        ranges.emplace_back(first, furthest);
+        ranges.emplace_back(furthest, last);
+      }
+    }
+
+    Route ret;
+    ret.reserve(std::count(kept.begin(), kept.end(), true));
+    for (std::size_t i = 0; i < route.size(); ++i) {
+      if (kept[i])
+        ret.push_back(route[i]);
+    }
+    return ret;
+  }
+
+  StreamSimplifier::StreamSimplifier(GPS::metres tolerance, Callback onKept, std::size_t windowSize)
+    : tolerance(tolerance), onKept(std::move(onKept)), windowSize(windowSize)
+  {
+    checkTolerance(tolerance);
+    if (windowSize == 0)
+      throw std::invalid_argument("The simplification window must hold at least one position.");
+    window.reserve(windowSize);
+  }
+
+  void StreamSimplifier::push_back(const GPS::Position & pos)
+  {
+    if (!anchor) {
+      anchor = pos;
+      onKept(pos);
+      return;
+    }
+
+    // The window's newest position must be kept if the segment to this one would not
+    // stay within the tolerance of the whole window.
+    if (!withinTolerance(pos))
+      keepNewest();
+
+    window.push_back(pos);
+    if (window.size() == windowSize)
+      keepNewest();
+  }
+
+  void StreamSimplifier::finish()
+  {
+    if (!window.empty())
+      keepNewest();
+    anchor.reset();
+  }
+
+  bool StreamSimplifier::withinTolerance(const GPS::Position & end) const
+  {
+    return std::all_of(window.begin(), window.end(), [&](const GPS::Position & pos) {
+      return GPS::distanceFromSegment(pos, *anchor, end) <= tolerance;
+    });
+  }
+
+  void StreamSimplifier::keepNewest()
+  {
+    anchor = window.back();
+    window.clear();
+    onKept(*anchor);
+  }
+}
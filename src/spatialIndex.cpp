@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+#include "earth.h"
+#include "geometry.h"
+#include "simplifyRoute.h"
+#include "spatialIndex.h"
+
+namespace NMEA
+{
+  namespace
+  {
+    // The distances to blocks of cells are reduced by this fraction, so that rounding cannot
+    // make them exceed the distance to an entry within the block.
+    const double BLOCK_DISTANCE_MARGIN = 1 - 1e-9;
+
+    // The fraction of a cell by which blocks of cells, and the columns crossed by a segment,
+    // are widened, so that rounding cannot leave out an entry that lies on their boundary.
+    const double CELL_SLACK = 1e-9;
+
+    // Keeps the keys of the cells, which interleave the bits of their row and column numbers
+    // above the level of a block, within 64 bits.
+    const GPS::metres MIN_CELL_SIZE = 1;
+
+    // A segment that spans more than this many cells (in rows and columns together) is held in
+    // the blocks of cells that it crosses instead, at the smallest level of blocks at which it
+    // spans no more than this many, so that it is held in only about this many cells or blocks.
+    const long MAX_SEGMENT_SPAN = 8;
+
+    // The low bits of a key, which hold the level of its block.
+    const int LEVEL_BITS = 6;
+    const int MAX_LEVEL = (1 << LEVEL_BITS) - 1;
+
+    // The bits of the lower 32 bits of x, in the even-numbered bits of the result.
+    std::uint64_t spreadBits(std::uint64_t x)
+    {
+      x &= 0x00000000FFFFFFFF;
+      x = (x | x << 16) & 0x0000FFFF0000FFFF;
+      x = (x | x << 8)  & 0x00FF00FF00FF00FF;
+      x = (x | x << 4)  & 0x0F0F0F0F0F0F0F0F;
+      x = (x | x << 2)  & 0x3333333333333333;
+      x = (x | x << 1)  & 0x5555555555555555;
+      return x;
+    }
+
+    // The inverse of spreadBits(), ignoring the odd-numbered bits.
+    std::uint64_t gatherBits(std::uint64_t x)
+    {
+      x &= 0x5555555555555555;
+      x = (x | x >> 1)  & 0x3333333333333333;
+      x = (x | x >> 2)  & 0x0F0F0F0F0F0F0F0F;
+      x = (x | x >> 4)  & 0x00FF00FF00FF00FF;
+      x = (x | x >> 8)  & 0x0000FFFF0000FFFF;
+      x = (x | x >> 16) & 0x00000000FFFFFFFF;
+      return x;
+    }
+
+    // The key of the first cell of a key's block, at level 0.
+    std::uint64_t keyCell(std::uint64_t key)
+    {
+      return key >> LEVEL_BITS;
+    }
+
+    int keyLevel(std::uint64_t key)
+    {
+      return MAX_LEVEL - int(key & MAX_LEVEL);
+    }
+
+    struct EntryHash
+    {
+      std::size_t operator()(SpatialIndex::Entry entry) const
+      {
+        return std::hash<std::size_t>()(entry.route) * 31 + std::hash<std::size_t>()(entry.index);
+      }
+    };
+
+    bool entryLess(SpatialIndex::Entry a, SpatialIndex::Entry b)
+    {
+      return a.route != b.route ? a.route < b.route : a.index < b.index;
+    }
+
+    // Orders matches by distance, breaking ties by entry so that results are deterministic.
+    bool nearer(const SpatialIndex::Match & a, const SpatialIndex::Match & b)
+    {
+      return a.distance != b.distance ? a.distance < b.distance : entryLess(a.entry, b.entry);
+    }
+
+    void checkRadius(GPS::metres radius)
+    {
+      if (!(radius >= 0))
+        throw std::invalid_argument("The search radius must not be negative.");
+    }
+  }
+
+  SpatialIndex::SpatialIndex(const Route & route, GPS::metres cellSize)
+    : routes{&route}
+  {
+    build(cellSize);
+  }
+
+  SpatialIndex::SpatialIndex(const std::vector<Route> & routes, GPS::metres cellSize)
+  {
+    for (const Route & route : routes)
+      this->routes.push_back(&route);
+    build(cellSize);
+  }
+
+  void SpatialIndex::build(GPS::metres cellSize)
+  {
+    if (!(cellSize >= MIN_CELL_SIZE))
+      throw std::invalid_argument("The cell size of a spatial index must be at least one metre.");
+
+    // Size the cells so that they are at least 'cellSize' across at every indexed position.
+    maxLatitude = 0;
+    for (const Route * route : routes) {
+      for (const GPS::Position & pos : *route)
+        maxLatitude = std::max(maxLatitude, std::fabs(pos.latitude()));
+    }
+    cellLatitude = GPS::Earth::latitudeSubtendedBy(cellSize);
+    rowCount = long(std::floor(GPS::halfRotation / cellLatitude)) + 1;
+    const GPS::degrees minCellLongitude = GPS::Earth::longitudeSubtendedBy(cellSize, maxLatitude);
+    if (minCellLongitude <= 0 || minCellLongitude >= GPS::halfRotation) {
+      columnCount = 1;
+      cellLongitude = GPS::fullRotation;
+    } else {
+      columnCount = long(std::floor(GPS::fullRotation / minCellLongitude));
+      cellLongitude = GPS::fullRotation / columnCount;
+    }
+
+    std::vector<std::pair<std::uint64_t, Entry>> pointCells, segmentCells;
+    for (std::size_t r = 0; r < routes.size(); ++r) {
+      const Route & route = *routes[r];
+      for (std::size_t i = 0; i < route.size(); ++i) {
+        pointCells.emplace_back(key(row(route[i].latitude()), column(route[i].longitude()), 0), Entry{r, i});
+      }
+
+      // Each segment is placed in every cell crossed by the straight line (in latitude and
+      // longitude, as in GPS::distanceFromSegment()) between its ends, or in every block of
+      // cells crossed at a level chosen for its length, so it occupies only a few of them.
+      for (std::size_t i = 0; i + 1 < route.size(); ++i) {
+        const GPS::Position & start = route[i], & end = route[i + 1];
+        const GPS::degrees startLon = start.longitude() - GPS::antiMeridianLongitude;
+        const GPS::degrees lonChange = GPS::normaliseDeg(end.longitude() - start.longitude());
+        const GPS::degrees latChange = end.latitude() - start.latitude();
+
+        const long startRow = row(start.latitude()), endRow = row(end.latitude());
+        const long span = std::labs(endRow - startRow) + std::min(long(std::fabs(lonChange) / cellLongitude) + 1, columnCount);
+        int level = 0;
+        while (span >> level > MAX_SEGMENT_SPAN)
+          ++level;
+        const GPS::degrees blockLatitude = cellLatitude * (1L << level);
+
+        const long firstRow = std::min(startRow, endRow) >> level, lastRow = std::max(startRow, endRow) >> level;
+        for (long segmentRow = firstRow; segmentRow <= lastRow; ++segmentRow) {
+          // The fractions of the way along the segment at which it enters and leaves the row.
+          double enter = 0, leave = 1;
+          if (firstRow != lastRow) {
+            const GPS::degrees rowStart = segmentRow * blockLatitude - GPS::poleLatitude;
+            const double a = (rowStart - start.latitude()) / latChange;
+            const double b = (rowStart + blockLatitude - start.latitude()) / latChange;
+            enter = std::clamp(std::min(a, b), 0.0, 1.0);
+            leave = std::clamp(std::max(a, b), 0.0, 1.0);
+          }
+          const GPS::degrees enterLon = startLon + enter * lonChange, leaveLon = startLon + leave * lonChange;
+          const long firstColumn = long(std::floor(std::min(enterLon, leaveLon) / cellLongitude - CELL_SLACK));
+          const long lastColumn = long(std::floor(std::max(enterLon, leaveLon) / cellLongitude + CELL_SLACK));
+          const long endColumn = firstColumn + std::min(lastColumn - firstColumn + 1, columnCount);
+          for (long c = firstColumn; c < endColumn; ) {
+            const long segmentColumn = (c % columnCount + columnCount) % columnCount;
+            segmentCells.emplace_back(key(segmentRow << level, segmentColumn, level), Entry{r, i});
+            // On to the next block, or to the first column if this block is the last.
+            c += std::min((((segmentColumn >> level) + 1) << level) - segmentColumn, columnCount - segmentColumn);
+          }
+        }
+      }
+    }
+
+    for (auto [cells, index] : {std::make_pair(&pointCells, &points), std::make_pair(&segmentCells, &segments)}) {
+      std::sort(cells->begin(), cells->end(), [](const auto & a, const auto & b) {
+        return a.first != b.first ? a.first < b.first : entryLess(a.second, b.second);
+      });
+      index->keys.reserve(cells->size());
+      index->entries.reserve(cells->size());
+      for (const auto & [cellKey, entry] : *cells) {
+        index->keys.push_back(cellKey);
+        index->entries.push_back(entry);
+      }
+    }
+  }
+
+  long SpatialIndex::row(GPS::degrees lat) const
+  {
+    const long ret = long(std::floor((lat + GPS::poleLatitude) / cellLatitude));
+    return std::clamp(ret, 0L, rowCount - 1);
+  }
+
+  long SpatialIndex::column(GPS::degrees lon) const
+  {
+    const long ret = long(std::floor((lon - GPS::antiMeridianLongitude) / cellLongitude)) % columnCount;
+    return ret < 0 ? ret + columnCount : ret;
+  }
+
+  std::uint64_t SpatialIndex::key(long row, long column, int level) const
+  {
+    const std::uint64_t cell = spreadBits(std::uint64_t(row)) << 1 | spreadBits(std::uint64_t(column));
+    return (cell >> 2 * level << 2 * level) << LEVEL_BITS | std::uint64_t(MAX_LEVEL - level);
+  }
+
+  const GPS::Position & SpatialIndex::position(Entry entry) const
+  {
+    return (*routes[entry.route])[entry.index];
+  }
+
+  const GPS::Position & SpatialIndex::segmentEnd(Entry entry) const
+  {
+    return (*routes[entry.route])[entry.index + 1];
+  }
+
+  SpatialIndex::Block SpatialIndex::block(const Cells & cells, const GPS::Position & pos, std::size_t first, std::size_t last) const
+  {
+    // The smallest aligned block that holds the first and last of the cells holds them all,
+    // unless the first is itself a larger block, which then holds all the others.
+    const std::uint64_t firstCell = keyCell(cells.keys[first]), differentBits = firstCell ^ keyCell(cells.keys[last - 1]);
+    int level = keyLevel(cells.keys[first]);
+    while (differentBits >> 2 * level != 0)
+      ++level;
+    const std::uint64_t blockCell = firstCell >> 2 * level << 2 * level;
+    return Block{distanceToBlock(pos, level, blockCell), level, blockCell, first, last};
+  }
+
+  GPS::metres SpatialIndex::distanceToBlock(const GPS::Position & pos, int level, std::uint64_t firstCell) const
+  {
+    const long firstRow = long(gatherBits(firstCell >> 1)), firstColumn = long(gatherBits(firstCell));
+    const long span = 1L << level;
+    const GPS::degrees south = std::max((firstRow - CELL_SLACK) * cellLatitude - GPS::poleLatitude, -GPS::poleLatitude);
+    const GPS::degrees north = std::min((firstRow + span + CELL_SLACK) * cellLatitude - GPS::poleLatitude, GPS::poleLatitude);
+    const GPS::degrees width = (std::min(firstColumn + span, columnCount) - firstColumn + 2 * CELL_SLACK) * cellLongitude;
+
+    // How far east of the block's western boundary the position is.
+    const GPS::degrees lat = pos.latitude();
+    GPS::degrees east = std::fmod(pos.longitude() - GPS::antiMeridianLongitude - (firstColumn - CELL_SLACK) * cellLongitude,
+                                  GPS::fullRotation);
+    if (east < 0)
+      east += GPS::fullRotation;
+
+    GPS::metres distance;
+    if (east <= width || width >= GPS::fullRotation) {
+      distance = GPS::Earth::meanRadius * GPS::degToRad(std::max({south - lat, lat - north, 0.0}));
+    } else {
+      // The nearest point of the block is on the nearer of its bounding meridians: at the foot
+      // of the perpendicular great circle from the position, if that is within the block, or
+      // otherwise at one of its corners.
+      const GPS::degrees lonGap = std::min(east - width, GPS::fullRotation - east);
+      const GPS::radians latRad = GPS::degToRad(lat), lonGapRad = GPS::degToRad(lonGap);
+      const GPS::degrees foot = GPS::radToDeg(std::atan2(std::sin(latRad), std::cos(latRad) * std::cos(lonGapRad)));
+      if (south <= foot && foot <= north)
+        distance = GPS::Earth::meanRadius * std::asin(std::cos(latRad) * std::sin(lonGapRad));
+      else
+        distance = std::min(GPS::Position::distanceBetween(GPS::Position(lat, 0), GPS::Position(south, lonGap)),
+                            GPS::Position::distanceBetween(GPS::Position(lat, 0), GPS::Position(north, lonGap)));
+    }
+    return std::max(0.0, distance * BLOCK_DISTANCE_MARGIN);
+  }
+
+  template <typename Visitor, typename Done>
+  void SpatialIndex::visitNearestFirst(const Cells & cells, const GPS::Position & pos, Visitor & visitor, Done & done,
+                                       QueryStats * stats) const
+  {
+    if (cells.keys.empty())
+      return;
+
+    // The blocks yet to be visited, with the nearest on top.
+    auto further = [](const Block & a, const Block & b) { return a.distance > b.distance; };
+    std::priority_queue<Block, std::vector<Block>, decltype(further)> blocks(further);
+    blocks.push(block(cells, pos, 0, cells.keys.size()));
+
+    while (!blocks.empty() && !done(blocks.top().distance)) {
+      const Block nearest = blocks.top();
+      blocks.pop();
+      if (stats)
+        ++stats->blocks;
+
+      // The entries of the block itself precede those of the smaller blocks within it.
+      const std::uint64_t blockKey = nearest.firstCell << LEVEL_BITS | std::uint64_t(MAX_LEVEL - nearest.level);
+      std::size_t first = nearest.first;
+      for (; first < nearest.last && cells.keys[first] == blockKey; ++first)
+        visitor(cells.entries[first]);
+
+      // Split the rest of the block into its occupied quarters.
+      const int quarterShift = LEVEL_BITS + 2 * (nearest.level - 1);
+      const auto lastKey = cells.keys.begin() + nearest.last;
+      for (std::size_t last; first < nearest.last; first = last) {
+        const std::uint64_t quarter = cells.keys[first] >> quarterShift;
+        last = std::partition_point(cells.keys.begin() + first, lastKey, [=](std::uint64_t cellKey) {
+          return cellKey >> quarterShift == quarter;
+        }) - cells.keys.begin();
+        blocks.push(block(cells, pos, first, last));
+      }
+    }
+  }
+
+  std::vector<SpatialIndex::Match> SpatialIndex::pointsWithin(const GPS::Position & pos, GPS::metres radius,
+                                                              QueryStats * stats) const
+  {
+    checkRadius(radius);
+    std::vector<Match> ret;
+    auto visitor = [&](Entry entry) {
+      const GPS::metres distance = GPS::Position::distanceBetween(pos, position(entry));
+      if (stats)
+        ++stats->distances;
+      if (distance <= radius)
+        ret.push_back(Match{entry, distance});
+    };
+    auto done = [radius](GPS::metres distance) { return distance > radius; };
+    visitNearestFirst(points, pos, visitor, done, stats);
+    std::sort(ret.begin(), ret.end(), nearer);
+    return ret;
+  }
+
+  std::optional<SpatialIndex::Match> SpatialIndex::nearestPoint(const GPS::Position & pos, QueryStats * stats) const
+  {
+    const std::vector<Match> nearest = nearestPoints(pos, 1, stats);
+    if (nearest.empty())
+      return std::nullopt;
+    return nearest.front();
+  }
+
+  std::vector<SpatialIndex::Match> SpatialIndex::nearestPoints(const GPS::Position & pos, std::size_t k,
+                                                               QueryStats * stats) const
+  {
+    // The k nearest so far, with the furthest of them on top.
+    std::priority_queue<Match, std::vector<Match>, decltype(&nearer)> nearest(nearer);
+    if (k == 0)
+      return {};
+
+    auto visitor = [&](Entry entry) {
+      const Match match{entry, GPS::Position::distanceBetween(pos, position(entry))};
+      if (stats)
+        ++stats->distances;
+      if (nearest.size() < k) {
+        nearest.push(match);
+      } else if (nearer(match, nearest.top())) {
+        nearest.pop();
+        nearest.push(match);
+      }
+    };
+    auto done = [&](GPS::metres distance) {
+      return nearest.size() == k && nearest.top().distance <= distance;
+    };
+    visitNearestFirst(points, pos, visitor, done, stats);
+
+    std::vector<Match> ret(nearest.size());
+    for (auto it = ret.rbegin(); it != ret.rend(); ++it) {
+      *it = nearest.top();
+      nearest.pop();
+    }
+    return ret;
+  }
+
+  std::vector<SpatialIndex::Match> SpatialIndex::segmentsWithin(const GPS::Position & pos, GPS::metres radius,
+                                                                QueryStats * stats) const
+  {
+    checkRadius(radius);
+    std::vector<Entry> visited;
+    auto visitor = [&](Entry entry) { visited.push_back(entry); };
+    auto done = [radius](GPS::metres distance) { return distance > radius; };
+    visitNearestFirst(segments, pos, visitor, done, stats);
+
+    // A segment may lie in several of the cells visited, but its distance is found only once.
+    std::sort(visited.begin(), visited.end(), entryLess);
+    visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+    std::vector<Match> ret;
+    for (Entry entry : visited) {
+      const GPS::metres distance = GPS::distanceFromSegment(pos, position(entry), segmentEnd(entry));
+      if (distance <= radius)
+        ret.push_back(Match{entry, distance});
+    }
+    if (stats)
+      stats->distances += visited.size();
+    std::sort(ret.begin(), ret.end(), nearer);
+    return ret;
+  }
+
+  std::optional<SpatialIndex::Match> SpatialIndex::nearestSegment(const GPS::Position & pos, QueryStats * stats) const
+  {
+    std::optional<Match> nearest;
+    std::unordered_set<Entry, EntryHash> visited;
+    auto visitor = [&](Entry entry) {
+      // A segment may lie in several of the cells visited.
+      if (!visited.insert(entry).second)
+        return;
+      const Match match{entry, GPS::distanceFromSegment(pos, position(entry), segmentEnd(entry))};
+      if (stats)
+        ++stats->distances;
+      if (!nearest || nearer(match, *nearest))
+        nearest = match;
+    };
+    auto done = [&](GPS::metres distance) {
+      return nearest && nearest->distance <= distance;
+    };
+    visitNearestFirst(segments, pos, visitor, done, stats);
+    return nearest;
+  }
+}
@@ -0,0 +1,81 @@
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "parseNMEA.h"
+#include "streamNMEA.h"
+
+namespace NMEA
+{
+  StreamParser::StreamParser(Callback callback)
+    : onPosition(std::move(callback)), partialLength(0), discarding(false), discarded(0) {}
+
+  void StreamParser::feed(std::string_view chunk)
+  {
+    while (!chunk.empty()) {
+      const char * newline = static_cast<const char *>(std::memchr(chunk.data(), '\n', chunk.size()));
+
+      if (newline == nullptr) {
+        // The line continues in a later chunk, so keep what we have of it.
+        if (discarding)
+          return;
+        if (partialLength + chunk.size() > bufferSize) {
+          discarding = true;
+          partialLength = 0;
+          return;
+        }
+        std::memcpy(partial.data() + partialLength, chunk.data(), chunk.size());
+        partialLength += chunk.size();
+        return;
+      }
+
+      const std::size_t lineLength = newline - chunk.data();
+      if (discarding) {
+        // The end of an overlong line.
+        discarding = false;
+        ++discarded;
+      }
+      else if (partialLength + lineLength > bufferSize) {
+        ++discarded;
+      }
+      else if (partialLength == 0) {
+        // The whole line is in this chunk, so parse it in place.
+        parseLine(chunk.substr(0, lineLength));
+      }
+      else {
+        std::memcpy(partial.data() + partialLength, chunk.data(), lineLength);
+        parseLine(std::string_view(partial.data(), partialLength + lineLength));
+      }
+      partialLength = 0;
+      chunk.remove_prefix(lineLength + 1);
+    }
+  }
+
+  void StreamParser::feed(const char * data, std::size_t length)
+  {
+    feed(std::string_view(data, length));
+  }
+
+  void StreamParser::finish()
+  {
+    if (discarding)
+      ++discarded;
+    else if (partialLength > 0)
+      parseLine(std::string_view(partial.data(), partialLength));
+
+    partialLength = 0;
+    discarding = false;
+  }
+
+  std::size_t StreamParser::overlongLines() const
+  {
+    return discarded;
+  }
+
+  void StreamParser::parseLine(std::string_view line)
+  {
+    if (std::optional<GPS::Position> pos = context.parseLine(line))
+      onPosition(*pos);
+  }
+}